@@ -1,50 +1,495 @@
 #include "aespl/gfx_animation.h"
 
+#include <stdatomic.h>
 #include <stdbool.h>
-#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "aespl/gfx.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "sdkconfig.h"
 
-static void animate_task(void *args) {
-    aespl_gfx_animation_t *anim = (aespl_gfx_animation_t *)args;
-    TickType_t delay = pdMS_TO_TICKS(1000 / anim->fps);
+#ifndef CONFIG_AESPL_GFX_ANIM_STACK_SIZE
+#define CONFIG_AESPL_GFX_ANIM_STACK_SIZE 4096
+#endif
 
-    for (;;) {
-        if (anim->state == AESPL_GFX_ANIM_RESTART) {
+#ifndef CONFIG_AESPL_GFX_ANIM_TASK_PRIORITY
+#define CONFIG_AESPL_GFX_ANIM_TASK_PRIORITY 0
+#endif
+
+#ifndef CONFIG_AESPL_GFX_ANIM_MAX_NUM
+#define CONFIG_AESPL_GFX_ANIM_MAX_NUM 16
+#endif
+
+// Control word of a slot: generation in bits 16-31, requested frame rate in
+// bits 8-15, the slot's state and requests to the animation task in bits 0-7
+#define CTL_USED (1 << 0)     // the slot holds an animation
+#define CTL_START (1 << 1)    // the animation is new
+#define CTL_STOP (1 << 2)     // stop and free the slot
+#define CTL_PAUSE (1 << 3)    // take the animation out of the queue
+#define CTL_RESUME (1 << 4)   // put the animation back into the queue
+#define CTL_RESTART (1 << 5)  // continue from the first frame
+#define CTL_FPS (1 << 6)      // change the frame rate
+#define CTL_REQUESTS \
+    (CTL_START | CTL_STOP | CTL_PAUSE | CTL_RESUME | CTL_RESTART | CTL_FPS)
+#define CTL_FPS_VALUE(ctl) (((ctl) >> 8) & 0xff)
+#define CTL_GEN(ctl) ((ctl) >> 16)
+
+/**
+ * Animation slot.
+ *
+ * Fields below `animator` are owned by the animation task once the slot is
+ * used.
+ */
+typedef struct aespl_gfx_animation {
+    _Atomic uint32_t ctl;              // control word
+    _Atomic uint8_t priority;          // order of simultaneous frames
+    _Atomic bool skip_frames;          // drop frames when late
+    _Atomic uint32_t stats_seq;        // odd while statistics are updated
+    aespl_gfx_anim_stats_t stats;      // statistics
+    aespl_gfx_animator_t animator;     // animation callback
+    void *args;                        // callback arguments
+    uint8_t fps;                       // frames per second
+    uint32_t frame_n;                  // number of the next frame
+    aespl_gfx_anim_state_t state;      // state returned by the animator
+    bool paused;                       // whether out of the queue
+    TickType_t start;                  // tick of the first frame slot
+    uint64_t slot_n;                   // number of the next frame slot
+    TickType_t wake;                   // tick of the next frame
+    struct aespl_gfx_animation *next;  // next animation to run
+} aespl_gfx_animation_t;
+
+static aespl_gfx_animation_t slots[CONFIG_AESPL_GFX_ANIM_MAX_NUM];
+
+// Animations ordered by the time of their next frames, owned by the
+// animation task
+static aespl_gfx_animation_t *queue;
+
+// Whether any slot has requests
+static atomic_bool requested;
+
+// States of the scheduler task
+enum {
+    SCHEDULER_NONE,
+    SCHEDULER_STARTING,
+    SCHEDULER_RUNNING,
+};
+
+// Set once the task is created, published by `scheduler_state`
+static TaskHandle_t scheduler;
+static _Atomic uint8_t scheduler_state;
+
+static inline aespl_gfx_anim_t make_handle(uint8_t i, uint32_t ctl) {
+    return CTL_GEN(ctl) << 16 | (i + 1);
+}
+
+static inline aespl_gfx_animation_t *get_slot(aespl_gfx_anim_t anim) {
+    uint32_t i = (anim & 0xffff) - 1;
+    return i < CONFIG_AESPL_GFX_ANIM_MAX_NUM ? &slots[i] : NULL;
+}
+
+// Whether a control word belongs to a handle's animation
+static inline bool is_instance(uint32_t ctl, aespl_gfx_anim_t anim) {
+    return (ctl & CTL_USED) && CTL_GEN(ctl) == anim >> 16;
+}
+
+// Tick of a frame slot counted from the start of an animation, calculated
+// from the slot number so that rounding errors do not accumulate
+static inline TickType_t slot_tick(TickType_t start, uint64_t slot_n,
+                                   uint8_t fps) {
+    return start + (TickType_t)(slot_n * configTICK_RATE_HZ / fps);
+}
+
+// Makes frame slots count from a given tick
+static inline void rebase(aespl_gfx_animation_t *anim, TickType_t tick) {
+    anim->start = anim->wake = tick;
+    anim->slot_n = 0;
+}
+
+static void update_stats(aespl_gfx_animation_t *anim, uint32_t us,
+                         uint32_t n_dropped) {
+    aespl_gfx_anim_stats_t *stats = &anim->stats;
+    uint32_t seq = atomic_load_explicit(&anim->stats_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&anim->stats_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (!stats->n_frames || us < stats->min_us) {
+        stats->min_us = us;
+    }
+    if (us > stats->max_us) {
+        stats->max_us = us;
+    }
+
+    stats->n_frames++;
+    stats->total_us += us;
+    stats->avg_us = stats->total_us / stats->n_frames;
+    stats->n_dropped += n_dropped;
+
+    atomic_store_explicit(&anim->stats_seq, seq + 2, memory_order_release);
+}
+
+// Whether an animation's frame must run before another one's
+static inline bool runs_before(const aespl_gfx_animation_t *a,
+                               const aespl_gfx_animation_t *b) {
+    int32_t diff = a->wake - b->wake;
+    return diff < 0 || (!diff && a->priority > b->priority);
+}
+
+static void enqueue(aespl_gfx_animation_t *anim) {
+    aespl_gfx_animation_t **p = &queue;
+
+    while (*p && !runs_before(anim, *p)) {
+        p = &(*p)->next;
+    }
+    anim->next = *p;
+    *p = anim;
+}
+
+static void unqueue(aespl_gfx_animation_t *anim) {
+    for (aespl_gfx_animation_t **p = &queue; *p; p = &(*p)->next) {
+        if (*p == anim) {
+            *p = anim->next;
+            return;
+        }
+    }
+}
+
+// Frees a slot, handles of its animation become invalid
+static void release(aespl_gfx_animation_t *anim) {
+    uint32_t ctl = atomic_load(&anim->ctl);
+    atomic_store(&anim->ctl, (CTL_GEN(ctl) + 1) << 16);
+}
+
+static void wake_scheduler(void) {
+    atomic_store(&requested, true);
+
+    if (xPortInIsrContext()) {
+        BaseType_t hptw = pdFALSE;
+        vTaskNotifyGiveFromISR(scheduler, &hptw);
+        if (hptw != pdFALSE) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+        xTaskNotifyGive(scheduler);
+    }
+}
+
+// Posts requests to an animation unless it has finished or is stopping
+static aespl_gfx_err_t request(aespl_gfx_anim_t anim, uint32_t set,
+                               uint32_t clear) {
+    aespl_gfx_animation_t *slot = get_slot(anim);
+    if (!slot) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    uint32_t ctl = atomic_load(&slot->ctl);
+    do {
+        if (!is_instance(ctl, anim) ||
+            ((ctl & CTL_STOP) && !(set & CTL_STOP))) {
+            return AESPL_GFX_FAIL;
+        }
+    } while (!atomic_compare_exchange_weak(&slot->ctl, &ctl,
+                                           (ctl & ~clear) | set));
+
+    wake_scheduler();
+
+    return AESPL_GFX_OK;
+}
+
+// Applies requests posted since the last call
+static void handle_requests(void) {
+    TickType_t now = xTaskGetTickCount();
+
+    for (uint8_t i = 0; i < CONFIG_AESPL_GFX_ANIM_MAX_NUM; i++) {
+        aespl_gfx_animation_t *anim = &slots[i];
+
+        uint32_t ctl = atomic_load(&anim->ctl);
+        while ((ctl & CTL_REQUESTS) &&
+               !atomic_compare_exchange_weak(&anim->ctl, &ctl,
+                                             ctl & ~CTL_REQUESTS)) {
+        }
+
+        uint32_t req = ctl & CTL_REQUESTS;
+        if (!req) {
+            continue;
+        }
+
+        if (req & CTL_STOP) {
+            unqueue(anim);
+            release(anim);
+            continue;
+        }
+
+        if (req & CTL_START) {
+            anim->frame_n = 0;
+            anim->state = AESPL_GFX_ANIM_CONTINUE;
+            anim->paused = false;
+            rebase(anim, now);
+            enqueue(anim);
+        }
+
+        // The next frame keeps its time
+        if (req & CTL_FPS) {
+            anim->fps = CTL_FPS_VALUE(ctl);
+            rebase(anim, anim->wake);
+        }
+
+        if (req & CTL_RESTART) {
             anim->frame_n = 0;
             anim->state = AESPL_GFX_ANIM_CONTINUE;
+            if (!anim->paused) {
+                unqueue(anim);
+                rebase(anim, now);
+                enqueue(anim);
+            }
+        }
+
+        if ((req & CTL_PAUSE) && !anim->paused) {
+            unqueue(anim);
+            anim->paused = true;
+        }
+
+        if ((req & CTL_RESUME) && anim->paused) {
+            anim->paused = false;
+            rebase(anim, now);
+            enqueue(anim);
+        }
+    }
+}
+
+// Runs a frame and schedules the next one, returns false if the animation
+// has stopped
+static bool run_frame(aespl_gfx_animation_t *anim) {
+    if (anim->state == AESPL_GFX_ANIM_RESTART) {
+        anim->frame_n = 0;
+        anim->state = AESPL_GFX_ANIM_CONTINUE;
+    }
+
+    int64_t t = esp_timer_get_time();
+    anim->state = anim->animator(anim->args, anim->frame_n++);
+    uint32_t us = esp_timer_get_time() - t;
+
+    if (anim->state == AESPL_GFX_ANIM_STOP) {
+        update_stats(anim, us, 0);
+        return false;
+    }
+
+    anim->wake = slot_tick(anim->start, ++anim->slot_n, anim->fps);
+
+    // Drop slots which have fully passed
+    TickType_t now = xTaskGetTickCount();
+    uint32_t n_dropped = 0;
+    if (anim->skip_frames && (int32_t)(now - anim->wake) >= 0) {
+        n_dropped = (uint64_t)(now - anim->wake) * anim->fps /
+                    configTICK_RATE_HZ;
+        anim->slot_n += n_dropped;
+        anim->frame_n += n_dropped;
+        anim->wake = slot_tick(anim->start, anim->slot_n, anim->fps);
+    }
+
+    // Readers of statistics see dropped frames together with the frame
+    update_stats(anim, us, n_dropped);
+
+    return true;
+}
+
+// Requests are posted without locks, so the queue is touched by this task
+// only and frames cost no mutex
+static void scheduler_task(void *args) {
+    for (;;) {
+        if (atomic_exchange(&requested, false)) {
+            handle_requests();
+        }
+
+        aespl_gfx_animation_t *anim = queue;
+        if (!anim) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // Sleep until the next frame or until a request comes
+        int32_t wait = anim->wake - xTaskGetTickCount();
+        if (wait > 0) {
+            ulTaskNotifyTake(pdTRUE, wait);
+            continue;
         }
 
-        if (anim->state == AESPL_GFX_ANIM_CONTINUE) {
-            anim->state = anim->animator(anim->args, anim->frame_n++);
-            vTaskDelay(delay);
+        queue = anim->next;
+        if (run_frame(anim)) {
+            enqueue(anim);
+        } else {
+            release(anim);
         }
+    }
+}
 
-        if (anim->state == AESPL_GFX_ANIM_STOP) {
-            free(anim);
+// Creates the scheduler on the first use. Creation is claimed by a CAS, which
+// unlike suspending the scheduler works across cores, and the task is created
+// outside of any critical section.
+static bool start_scheduler(void) {
+    for (;;) {
+        uint8_t state = SCHEDULER_NONE;
+        if (atomic_compare_exchange_strong(&scheduler_state, &state,
+                                           SCHEDULER_STARTING)) {
             break;
         }
+        if (state == SCHEDULER_RUNNING) {
+            return true;
+        }
+
+        // Another task is creating it
+        vTaskDelay(1);
+    }
+
+    TaskHandle_t task;
+    if (xTaskCreate(scheduler_task, "animation",
+                    CONFIG_AESPL_GFX_ANIM_STACK_SIZE, NULL,
+                    CONFIG_AESPL_GFX_ANIM_TASK_PRIORITY, &task) != pdPASS) {
+        atomic_store(&scheduler_state, SCHEDULER_NONE);
+        return false;
+    }
+
+    scheduler = task;
+    atomic_store(&scheduler_state, SCHEDULER_RUNNING);
+
+    return true;
+}
+
+aespl_gfx_anim_t aespl_gfx_animate(aespl_gfx_animator_t fn, void *args,
+                                   uint8_t fps) {
+    if (!fn || !fps || !start_scheduler()) {
+        return AESPL_GFX_ANIM_NONE;
+    }
+
+    for (uint8_t i = 0; i < CONFIG_AESPL_GFX_ANIM_MAX_NUM; i++) {
+        aespl_gfx_animation_t *anim = &slots[i];
+
+        uint32_t ctl = atomic_load(&anim->ctl);
+        if ((ctl & CTL_USED) ||
+            !atomic_compare_exchange_strong(&anim->ctl, &ctl,
+                                            ctl | CTL_USED)) {
+            continue;
+        }
+
+        // The animation task does not touch the slot until it is started
+        anim->animator = fn;
+        anim->args = args;
+        anim->fps = fps;
+        atomic_store(&anim->priority, 0);
+        atomic_store(&anim->skip_frames, false);
+        memset(&anim->stats, 0, sizeof(anim->stats));
+
+        atomic_fetch_or(&anim->ctl, CTL_START);
+        wake_scheduler();
+
+        return make_handle(i, ctl);
+    }
+
+    return AESPL_GFX_ANIM_NONE;
+}
+
+bool aespl_gfx_anim_is_active(aespl_gfx_anim_t anim) {
+    aespl_gfx_animation_t *slot = get_slot(anim);
+    return slot && is_instance(atomic_load(&slot->ctl), anim);
+}
+
+aespl_gfx_err_t aespl_gfx_anim_pause(aespl_gfx_anim_t anim) {
+    return request(anim, CTL_PAUSE, CTL_RESUME);
+}
+
+aespl_gfx_err_t aespl_gfx_anim_resume(aespl_gfx_anim_t anim) {
+    return request(anim, CTL_RESUME, CTL_PAUSE);
+}
+
+aespl_gfx_err_t aespl_gfx_anim_restart(aespl_gfx_anim_t anim) {
+    return request(anim, CTL_RESTART, 0);
+}
+
+aespl_gfx_err_t aespl_gfx_anim_set_fps(aespl_gfx_anim_t anim, uint8_t fps) {
+    if (!fps) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    return request(anim, CTL_FPS | (uint32_t)fps << 8, 0xff00);
+}
+
+aespl_gfx_err_t aespl_gfx_anim_set_priority(aespl_gfx_anim_t anim,
+                                            uint8_t priority) {
+    aespl_gfx_animation_t *slot = get_slot(anim);
+    if (!slot) {
+        return AESPL_GFX_BAD_ARG;
+    }
+    if (!is_instance(atomic_load(&slot->ctl), anim)) {
+        return AESPL_GFX_FAIL;
     }
 
-    vTaskDelete(NULL);
+    // Read by the animation task when it schedules the next frame
+    atomic_store(&slot->priority, priority);
+
+    return AESPL_GFX_OK;
 }
 
-aespl_gfx_animation_t *aespl_gfx_animate(aespl_gfx_animator_t fn, void *args,
-                                         uint8_t fps) {
-    aespl_gfx_animation_t *anim = malloc(sizeof(aespl_gfx_animation_t));
-    if (!anim) {
-        return NULL;
+aespl_gfx_err_t aespl_gfx_anim_set_skip_frames(aespl_gfx_anim_t anim,
+                                               bool skip_frames) {
+    aespl_gfx_animation_t *slot = get_slot(anim);
+    if (!slot) {
+        return AESPL_GFX_BAD_ARG;
+    }
+    if (!is_instance(atomic_load(&slot->ctl), anim)) {
+        return AESPL_GFX_FAIL;
+    }
+
+    // Read by the animation task when it schedules the next frame
+    atomic_store(&slot->skip_frames, skip_frames);
+
+    return AESPL_GFX_OK;
+}
+
+aespl_gfx_err_t aespl_gfx_anim_get_stats(aespl_gfx_anim_t anim,
+                                         aespl_gfx_anim_stats_t *stats) {
+    aespl_gfx_animation_t *slot = get_slot(anim);
+    if (!slot) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    // Retry while the animation task is updating them
+    for (;;) {
+        uint32_t seq =
+            atomic_load_explicit(&slot->stats_seq, memory_order_acquire);
+        if (!(seq & 1)) {
+            *stats = slot->stats;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->stats_seq,
+                                     memory_order_relaxed) == seq) {
+                break;
+            }
+        }
+
+        // Let the animation task finish the update
+        vTaskDelay(1);
     }
 
-    anim->animator = fn;
-    anim->args = args;
-    anim->fps = fps;
-    anim->frame_n = 0;
-    anim->state = AESPL_GFX_ANIM_CONTINUE;
+    return aespl_gfx_anim_is_active(anim) ? AESPL_GFX_OK : AESPL_GFX_FAIL;
+}
 
-    xTaskCreate(animate_task, "animation", 4096, (void *)anim, 0, NULL);
+aespl_gfx_err_t aespl_gfx_anim_stop(aespl_gfx_anim_t anim) {
+    return request(anim, CTL_STOP, 0);
+}
+
+aespl_gfx_err_t aespl_gfx_anim_join(aespl_gfx_anim_t anim) {
+    aespl_gfx_err_t err = request(anim, CTL_STOP, 0);
+    if (err != AESPL_GFX_OK || xTaskGetCurrentTaskHandle() == scheduler) {
+        return err;
+    }
+
+    // The slot's generation changes once it is freed; joining is rare, so
+    // polling it costs less than a synchronization object per slot
+    while (aespl_gfx_anim_is_active(anim)) {
+        vTaskDelay(1);
+    }
 
-    return anim;
+    return AESPL_GFX_OK;
 }
@@ -0,0 +1,240 @@
+#include "aespl/gfx_blend.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_px.h"
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+// RGB565 spread over a word, so that each channel has room to grow:
+// green in bits 21-26, red in bits 11-15, blue in bits 0-4
+#define RGB565_SPREAD_MASK 0x07e0f81f
+
+// Alpha of a source pixel scaled by opacity, in range 0..256, where 256 means
+// the source replaces the destination
+static inline uint32_t src_alpha(uint32_t src, uint8_t opacity) {
+    uint32_t a = ((src >> 24) * (opacity + 1)) >> 8;
+    return a + (a >> 7);
+}
+
+// Interpolates between two colors, two channels per multiplication
+static inline uint32_t argb888_lerp(uint32_t d, uint32_t s, uint32_t a) {
+    uint32_t rb = (s & 0xff00ff) * a + (d & 0xff00ff) * (256 - a);
+    uint32_t ag = ((s >> 8) & 0xff00ff) * a + ((d >> 8) & 0xff00ff) * (256 - a);
+    return ((rb >> 8) & 0xff00ff) | (ag & 0xff00ff00);
+}
+
+// Adds two colors, each channel saturates at 255
+static inline uint32_t argb888_add(uint32_t d, uint32_t s) {
+    uint32_t rb = (d & 0xff00ff) + (s & 0xff00ff);
+    uint32_t ag = ((d >> 8) & 0xff00ff) + ((s >> 8) & 0xff00ff);
+
+    // Carries of overflowed channels turn into all-ones channels
+    uint32_t c = rb & 0x1000100;
+    rb = (rb | (c - (c >> 8))) & 0xff00ff;
+    c = ag & 0x1000100;
+    ag = (ag | (c - (c >> 8))) & 0xff00ff;
+
+    return rb | ag << 8;
+}
+
+// Multiplies RGB channels of two colors, alpha becomes opaque
+static inline uint32_t argb888_mul(uint32_t d, uint32_t s) {
+    uint32_t res = 0xff000000;
+    for (uint8_t shift = 0; shift < 24; shift += 8) {
+        uint32_t dc = (d >> shift) & 0xff, sc = (s >> shift) & 0xff;
+        res |= ((dc * (sc + 1)) >> 8) << shift;
+    }
+    return res;
+}
+
+static inline uint32_t argb888_blend(aespl_gfx_blend_t mode, uint32_t d,
+                                     uint32_t s, uint32_t a) {
+    switch (mode) {
+        case AESPL_GFX_BLEND_OVER:
+            // Resulting alpha moves towards opaque as well
+            return argb888_lerp(d, s | 0xff000000, a);
+
+        case AESPL_GFX_BLEND_ADD: {
+            uint32_t rb = (((s & 0xff00ff) * a) >> 8) & 0xff00ff;
+            uint32_t g = (((s & 0xff00) * a) >> 8) & 0xff00;
+            return argb888_add(d, MIN(a, 255) << 24 | rb | g);
+        }
+
+        case AESPL_GFX_BLEND_MULTIPLY:
+            return argb888_lerp(d, argb888_mul(d, s), a);
+    }
+
+    return d;
+}
+
+static inline uint32_t rgb565_spread(uint16_t c) {
+    return (c | (uint32_t)c << 16) & RGB565_SPREAD_MASK;
+}
+
+static inline uint16_t rgb565_join(uint32_t c) {
+    c &= RGB565_SPREAD_MASK;
+    return c | c >> 16;
+}
+
+static inline uint16_t rgb565_blend(aespl_gfx_blend_t mode, uint16_t d,
+                                    uint32_t s, uint32_t a) {
+    // Five bits of alpha leave enough room for channels to be multiplied
+    uint32_t a5 = a >> 3;
+    uint32_t sd = rgb565_spread(d);
+
+    switch (mode) {
+        case AESPL_GFX_BLEND_OVER:
+            break;
+
+        case AESPL_GFX_BLEND_ADD: {
+            uint32_t ss = rgb565_spread(aespl_gfx_argb888_to_rgb565(s));
+            uint32_t sum = sd + (((ss * a5) >> 5) & RGB565_SPREAD_MASK);
+
+            // Carries of red and blue are 5 bits above, green's are 6
+            uint32_t c_rb = sum & 0x00010020, c_g = sum & 0x08000000;
+            sum |= (c_rb - (c_rb >> 5)) | (c_g - (c_g >> 6));
+            return rgb565_join(sum);
+        }
+
+        case AESPL_GFX_BLEND_MULTIPLY:
+            s = argb888_mul(aespl_gfx_rgb565_to_argb888(d), s);
+            break;
+    }
+
+    uint32_t ss = rgb565_spread(aespl_gfx_argb888_to_rgb565(s));
+    return rgb565_join((ss * a5 + sd * (32 - a5)) >> 5);
+}
+
+// Blends a run of ARGB888 pixels. Rows of both buffers are stored in reverse
+// order, so pixels match each other in memory order.
+AESPL_GFX_PX_INLINE bool argb888_row(aespl_gfx_blend_t mode, uint32_t *d,
+                                     const uint32_t *s, int32_t w,
+                                     uint8_t opacity) {
+    bool changed = false;
+
+    for (int32_t i = 0; i < w; i++) {
+        uint32_t a = src_alpha(s[i], opacity);
+        if (!a) {
+            continue;
+        }
+
+        uint32_t v = (mode == AESPL_GFX_BLEND_OVER && a == 256)
+                         ? s[i]
+                         : argb888_blend(mode, d[i], s[i], a);
+        changed |= v != d[i];
+        d[i] = v;
+    }
+
+    return changed;
+}
+
+// Blends a run of ARGB888 pixels onto RGB565 ones. Destination pixels follow
+// from left to right, source ones from right to left in memory.
+AESPL_GFX_PX_INLINE bool rgb565_row(aespl_gfx_blend_t mode, uint16_t *d,
+                                    const uint32_t *s, int32_t w,
+                                    uint8_t opacity) {
+    bool changed = false;
+
+    for (int32_t i = 0; i < w; i++) {
+        uint32_t sc = *(s - i);
+        uint32_t a = src_alpha(sc, opacity);
+        if (!a) {
+            continue;
+        }
+
+        uint16_t dc = AESPL_GFX_RGB565_BE(d[i]);
+        uint16_t v = (mode == AESPL_GFX_BLEND_OVER && a == 256)
+                         ? aespl_gfx_argb888_to_rgb565(sc)
+                         : rgb565_blend(mode, dc, sc, a);
+        changed |= v != dc;
+        d[i] = AESPL_GFX_RGB565_BE(v);
+    }
+
+    return changed;
+}
+
+uint32_t aespl_gfx_blend_argb888(uint32_t dst, uint32_t src,
+                                 aespl_gfx_blend_t mode, uint8_t opacity) {
+    uint32_t a = src_alpha(src, opacity);
+    return a ? argb888_blend(mode, dst, src, a) : dst;
+}
+
+aespl_gfx_err_t aespl_gfx_blend(aespl_gfx_buf_t *dst,
+                                const aespl_gfx_buf_t *src,
+                                aespl_gfx_point_t pos, aespl_gfx_blend_t mode,
+                                uint8_t opacity) {
+    if (src->c_mode != AESPL_GFX_C_MODE_ARGB888 ||
+        (dst->c_mode != AESPL_GFX_C_MODE_ARGB888 &&
+         dst->c_mode != AESPL_GFX_C_MODE_RGB565) ||
+        mode > AESPL_GFX_BLEND_MULTIPLY) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    // Clip the source against the target
+    int32_t dx = MAX(pos.x, 0), dy = MAX(pos.y, 0);
+    int32_t w = MIN(pos.x + src->width, (int32_t)dst->width) - dx;
+    int32_t h = MIN(pos.y + src->height, (int32_t)dst->height) - dy;
+    int32_t sx = dx - pos.x, sy = dy - pos.y;
+    if (w <= 0 || h <= 0 || !opacity) {
+        return AESPL_GFX_OK;
+    }
+
+    for (int32_t r = 0; r < h; r++) {
+        const uint32_t *s_row = src->content[sy + r];
+        uint32_t *d_row = dst->content[dy + r];
+        bool changed = false;
+
+        // Each blend mode gets its own copy of the loop
+        if (dst->c_mode == AESPL_GFX_C_MODE_ARGB888) {
+            uint32_t *d = d_row + dst->wpr - dx - w;
+            const uint32_t *s = s_row + src->wpr - sx - w;
+            switch (mode) {
+                case AESPL_GFX_BLEND_OVER:
+                    changed = argb888_row(AESPL_GFX_BLEND_OVER, d, s, w,
+                                          opacity);
+                    break;
+                case AESPL_GFX_BLEND_ADD:
+                    changed = argb888_row(AESPL_GFX_BLEND_ADD, d, s, w,
+                                          opacity);
+                    break;
+                case AESPL_GFX_BLEND_MULTIPLY:
+                    changed = argb888_row(AESPL_GFX_BLEND_MULTIPLY, d, s, w,
+                                          opacity);
+                    break;
+            }
+        } else {
+            uint16_t *d = (uint16_t *)d_row + dx;
+            const uint32_t *s = s_row + src->wpr - 1 - sx;
+            switch (mode) {
+                case AESPL_GFX_BLEND_OVER:
+                    changed = rgb565_row(AESPL_GFX_BLEND_OVER, d, s, w,
+                                         opacity);
+                    break;
+                case AESPL_GFX_BLEND_ADD:
+                    changed = rgb565_row(AESPL_GFX_BLEND_ADD, d, s, w,
+                                         opacity);
+                    break;
+                case AESPL_GFX_BLEND_MULTIPLY:
+                    changed = rgb565_row(AESPL_GFX_BLEND_MULTIPLY, d, s, w,
+                                         opacity);
+                    break;
+            }
+        }
+
+        if (changed) {
+            aespl_gfx_mark_dirty(dst, (aespl_gfx_point_t){dx, dy + r},
+                                 (aespl_gfx_point_t){dx + w - 1, dy + r});
+        }
+    }
+
+    return AESPL_GFX_OK;
+}
@@ -1,15 +1,92 @@
 #include "aespl/gfx_buffer.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "aespl/gfx_geometry.h"
+#include "aespl/gfx_px.h"
 #include "aespl/util.h"
 
-aespl_gfx_buf_t *aespl_gfx_make_buf(uint16_t width, uint16_t height,
-                                    aespl_gfx_c_mode_t c_mode) {
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+// Pixels per word
+static uint8_t c_mode_ppw(aespl_gfx_c_mode_t c_mode) {
+    switch (c_mode) {
+        case AESPL_GFX_C_MODE_MONO:
+            return sizeof(uint32_t) * 8;  // 32 pixels per word
+        case AESPL_GFX_C_MODE_RGB565:
+            return sizeof(uint32_t) * 8 / 16;  // 2 pixels per word
+        case AESPL_GFX_C_MODE_ARGB888:
+            return 1;  // 1 pixel per word
+    }
+
+    return 1;
+}
+
+// Words per row
+static uint16_t c_mode_wpr(uint16_t width, aespl_gfx_c_mode_t c_mode) {
+    return 1 + ((width - 1) / c_mode_ppw(c_mode));
+}
+
+// Size of a dirty region, one bit per row
+static size_t dirty_size(uint16_t height) {
+    return sizeof(aespl_gfx_dirty_t) + (1 + height / 32) * sizeof(uint32_t);
+}
+
+// Size of the buffer's header, row pointers and room for a dirty region,
+// rounded up to a word boundary
+static size_t buf_header_size(uint16_t height) {
+    size_t size = sizeof(aespl_gfx_buf_t) + height * sizeof(uint32_t *) +
+                  dirty_size(height);
+    return (size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+// Size of an array's header and buffer pointers, rounded up to a word boundary
+static size_t buf_array_header_size(uint8_t length) {
+    size_t size =
+        sizeof(aespl_gfx_buf_array_t) + length * sizeof(aespl_gfx_buf_t *);
+    return (size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+// Sets up a contiguous buffer inside a memory block
+static aespl_gfx_buf_t *buf_init(void *mem, uint16_t width, uint16_t height,
+                                 aespl_gfx_c_mode_t c_mode,
+                                 aespl_gfx_buf_storage_t storage) {
+    aespl_gfx_buf_t *buf = mem;
+    buf->width = width;
+    buf->height = height;
+    buf->c_mode = c_mode;
+    buf->storage = storage;
+    buf->ppw = c_mode_ppw(c_mode);
+    buf->wpr = c_mode_wpr(width, c_mode);
+    buf->dirty = NULL;
+
+    // Row pointers follow the header, then the room for a dirty region and
+    // pixels
+    buf->content = (uint32_t **)(buf + 1);
+    uint32_t *px = (uint32_t *)((uint8_t *)mem + buf_header_size(height));
+    for (uint16_t r = 0; r < height; r++) {
+        buf->content[r] = px + r * buf->wpr;
+    }
+
+    // Fill buffer with zeros
+    aespl_gfx_clear_buf(buf);
+
+    return buf;
+}
+
+// Allocates each row of a buffer separately
+static aespl_gfx_buf_t *make_buf_rows(uint16_t width, uint16_t height,
+                                      aespl_gfx_c_mode_t c_mode) {
     aespl_gfx_buf_t *buf = malloc(sizeof(aespl_gfx_buf_t));
     if (!buf) {
         return NULL;
@@ -17,62 +94,126 @@ aespl_gfx_buf_t *aespl_gfx_make_buf(uint16_t width, uint16_t height,
     buf->width = width;
     buf->height = height;
     buf->c_mode = c_mode;
+    buf->storage = AESPL_GFX_BUF_STORAGE_ROWS;
+    buf->ppw = c_mode_ppw(c_mode);
+    buf->wpr = c_mode_wpr(width, c_mode);
+    buf->dirty = NULL;
 
-    buf->content = calloc(height, sizeof(buf->content));  // pointers to rows
+    buf->content = calloc(height, sizeof(*buf->content));  // pointers to rows
     if (!buf->content) {
         free(buf);
         return NULL;
     }
 
-    // Pixels per row
-    switch (c_mode) {
-        case AESPL_GFX_C_MODE_MONO:
-            buf->ppw = sizeof(**buf->content) * 8;  // 8 pixels per word
-            break;
-        case AESPL_GFX_C_MODE_RGB565:
-            buf->ppw = sizeof(**buf->content) * 8 / 16;  // 2 pixels per word
-            break;
-        case AESPL_GFX_C_MODE_ARGB888:
-            buf->ppw = 1;  // 1 pixel per word
-            break;
-    }
-
-    // Words per row
-    buf->wpr = 1 + ((width - 1) / buf->ppw);
-
-    // Allocate memory for content
+    // Allocate memory for each row
     for (uint16_t r = 0; r < height; r++) {
-        // Allocate memory for each row
-        buf->content[r] = calloc(buf->wpr, sizeof(*buf->content));
+        buf->content[r] = calloc(buf->wpr, sizeof(**buf->content));
         if (!buf->content[r]) {
-            free(buf->content);
-            free(buf);
+            buf->height = r;
+            aespl_gfx_free_buf(buf);
             return NULL;
         }
     }
 
-    // Fill buffer with zeros
-    aespl_gfx_clear_buf(buf);
-
     return buf;
 }
 
+// Sets up an array and its contiguous buffers inside a memory block
+static aespl_gfx_buf_array_t *buf_array_init(void *mem, uint8_t length,
+                                             uint16_t width, uint16_t height,
+                                             aespl_gfx_c_mode_t c_mode,
+                                             aespl_gfx_buf_storage_t storage) {
+    aespl_gfx_buf_array_t *buf_arr = mem;
+    buf_arr->length = length;
+    buf_arr->c_mode = c_mode;
+    buf_arr->storage = storage;
+    buf_arr->buffers = (aespl_gfx_buf_t **)(buf_arr + 1);
+
+    // Buffers are owned by the array
+    uint8_t *b_mem = (uint8_t *)mem + buf_array_header_size(length);
+    size_t b_size = aespl_gfx_buf_size(width, height, c_mode);
+    for (uint8_t i = 0; i < length; i++) {
+        buf_arr->buffers[i] = buf_init(b_mem + i * b_size, width, height,
+                                       c_mode, AESPL_GFX_BUF_STORAGE_EXTERNAL);
+    }
+
+    return buf_arr;
+}
+
+size_t aespl_gfx_buf_size(uint16_t width, uint16_t height,
+                          aespl_gfx_c_mode_t c_mode) {
+    return buf_header_size(height) +
+           height * c_mode_wpr(width, c_mode) * sizeof(uint32_t);
+}
+
+aespl_gfx_buf_t *aespl_gfx_init_buf(void *mem, uint16_t width, uint16_t height,
+                                    aespl_gfx_c_mode_t c_mode) {
+    if (!aespl_gfx_c_mode_enabled(c_mode)) {
+        return NULL;
+    }
+
+    return buf_init(mem, width, height, c_mode,
+                    AESPL_GFX_BUF_STORAGE_EXTERNAL);
+}
+
+aespl_gfx_buf_t *aespl_gfx_make_buf(uint16_t width, uint16_t height,
+                                    aespl_gfx_c_mode_t c_mode) {
+    if (!aespl_gfx_c_mode_enabled(c_mode)) {
+        return NULL;
+    }
+
+    void *mem = malloc(aespl_gfx_buf_size(width, height, c_mode));
+    if (mem) {
+        return buf_init(mem, width, height, c_mode,
+                        AESPL_GFX_BUF_STORAGE_CONTIGUOUS);
+    }
+
+    // The heap is too fragmented to get a single block
+    return make_buf_rows(width, height, c_mode);
+}
+
 void aespl_gfx_free_buf(aespl_gfx_buf_t *buf) {
-    // Rows
-    for (uint16_t r = 0; r < buf->height; r++) {
-        free(buf->content[r]);
+    if (!buf) {
+        return;
     }
 
-    // Pointers to rows
-    free(buf->content);
+    if (buf->storage == AESPL_GFX_BUF_STORAGE_ROWS) {
+        // Rows
+        for (uint16_t r = 0; r < buf->height; r++) {
+            free(buf->content[r]);
+        }
+
+        // Pointers to rows
+        free(buf->content);
+    }
+
+    // Dirty region
+    if (buf->storage == AESPL_GFX_BUF_STORAGE_ROWS) {
+        free(buf->dirty);
+    }
+    buf->dirty = NULL;
 
     // Pointer to structure
-    free(buf);
+    if (buf->storage != AESPL_GFX_BUF_STORAGE_EXTERNAL) {
+        free(buf);
+    }
 }
 
 aespl_gfx_buf_array_t *aespl_gfx_make_buf_array(uint8_t length, uint16_t width,
                                                 uint16_t height,
                                                 aespl_gfx_c_mode_t c_mode) {
+    if (!aespl_gfx_c_mode_enabled(c_mode)) {
+        return NULL;
+    }
+
+    // Try to place the array and all its buffers into a single block
+    void *mem = malloc(aespl_gfx_buf_array_size(length, width, height, c_mode));
+    if (mem) {
+        return buf_array_init(mem, length, width, height, c_mode,
+                              AESPL_GFX_BUF_STORAGE_CONTIGUOUS);
+    }
+
+    // The heap is too fragmented, allocate each buffer separately
     aespl_gfx_buf_array_t *buf_arr = malloc(sizeof(aespl_gfx_buf_array_t));
     if (!buf_arr) {
         return NULL;
@@ -80,25 +221,103 @@ aespl_gfx_buf_array_t *aespl_gfx_make_buf_array(uint8_t length, uint16_t width,
 
     buf_arr->length = length;
     buf_arr->c_mode = c_mode;
+    buf_arr->storage = AESPL_GFX_BUF_STORAGE_ROWS;
     buf_arr->buffers = calloc(length, sizeof(aespl_gfx_buf_t *));
+    if (!buf_arr->buffers) {
+        free(buf_arr);
+        return NULL;
+    }
 
     for (uint8_t i = 0; i < length; i++) {
         buf_arr->buffers[i] = aespl_gfx_make_buf(width, height, c_mode);
+        if (!buf_arr->buffers[i]) {
+            aespl_gfx_free_buf_array(buf_arr);
+            return NULL;
+        }
     }
 
     return buf_arr;
 }
 
+size_t aespl_gfx_buf_array_size(uint8_t length, uint16_t width,
+                                uint16_t height, aespl_gfx_c_mode_t c_mode) {
+    return buf_array_header_size(length) +
+           length * aespl_gfx_buf_size(width, height, c_mode);
+}
+
+aespl_gfx_buf_array_t *aespl_gfx_init_buf_array(void *mem, uint8_t length,
+                                                uint16_t width, uint16_t height,
+                                                aespl_gfx_c_mode_t c_mode) {
+    if (!aespl_gfx_c_mode_enabled(c_mode)) {
+        return NULL;
+    }
+
+    return buf_array_init(mem, length, width, height, c_mode,
+                          AESPL_GFX_BUF_STORAGE_EXTERNAL);
+}
+
 void aespl_gfx_free_buf_array(aespl_gfx_buf_array_t *buf_arr) {
+    if (!buf_arr) {
+        return;
+    }
+
     for (uint16_t i = 0; i < buf_arr->length; i++) {
         aespl_gfx_free_buf(buf_arr->buffers[i]);
     }
 
-    free(buf_arr->buffers);
-    free(buf_arr);
+    if (buf_arr->storage == AESPL_GFX_BUF_STORAGE_ROWS) {
+        free(buf_arr->buffers);
+    }
+
+    if (buf_arr->storage != AESPL_GFX_BUF_STORAGE_EXTERNAL) {
+        free(buf_arr);
+    }
+}
+
+// Marks a rectangle which is known to be inside of the buffer as dirty
+static void dirty_mark(aespl_gfx_buf_t *buf, int32_t x1, int32_t y1,
+                       int32_t x2, int32_t y2) {
+    aespl_gfx_dirty_t *d = buf->dirty;
+
+    for (int32_t y = y1; y <= y2; y++) {
+        d->rows[y / 32] |= 1U << (y % 32);
+    }
+
+    if (!d->is_dirty) {
+        d->is_dirty = true;
+        d->p1 = (aespl_gfx_point_t){x1, y1};
+        d->p2 = (aespl_gfx_point_t){x2, y2};
+        return;
+    }
+
+    d->p1.x = MIN(d->p1.x, x1);
+    d->p1.y = MIN(d->p1.y, y1);
+    d->p2.x = MAX(d->p2.x, x2);
+    d->p2.y = MAX(d->p2.y, y2);
 }
 
 void aespl_gfx_clear_buf(aespl_gfx_buf_t *buf) {
+    if (buf->dirty) {
+        // Only rows which had something drawn become dirty
+        for (uint16_t r = 0; r < buf->height; r++) {
+            for (uint16_t w = 0; w < buf->wpr; w++) {
+                if (buf->content[r][w]) {
+                    memset(buf->content[r], 0,
+                           buf->wpr * sizeof(**buf->content));
+                    dirty_mark(buf, 0, r, buf->width - 1, r);
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    if (buf->storage != AESPL_GFX_BUF_STORAGE_ROWS && buf->height) {
+        memset(buf->content[0], 0,
+               buf->height * buf->wpr * sizeof(**buf->content));
+        return;
+    }
+
     for (uint16_t r = 0; r < buf->height; r++) {
         memset(buf->content[r], 0, buf->wpr * sizeof(**buf->content));
     }
@@ -136,27 +355,96 @@ void aespl_gfx_set_px(aespl_gfx_buf_t *buf, int16_t x, int16_t y,
         return;
     }
 
-    size_t word_bits = sizeof(**buf->content) * 8;
-    uint16_t word_n = buf->wpr - 1 - x / buf->ppw;
+    if (aespl_gfx_mode_set_px(buf->c_mode, buf, x, y, color) && buf->dirty) {
+        dirty_mark(buf, x, y, x, y);
+    }
+}
+
+void aespl_gfx_fill_span(aespl_gfx_buf_t *buf, int16_t y, int32_t x1,
+                         int32_t x2, uint32_t color) {
+    if (x1 > x2) {
+        int32_t tmp = x1;
+        x1 = x2;
+        x2 = tmp;
+    }
+
+    // It's okay to fill outside buffer's boundaries
+    x1 = MAX(x1, 0);
+    x2 = MIN(x2, buf->width - 1);
+    if (y < 0 || y >= buf->height || x1 > x2) {
+        return;
+    }
+
+    uint32_t *row = buf->content[y];
+    uint32_t changed = 0;
+    int32_t from = x1, to = x2;
 
     switch (buf->c_mode) {
-        case AESPL_GFX_C_MODE_MONO:
-            if (color == 0) {
-                buf->content[y][word_n] &=
-                    ~(1 << (word_bits - x - 1 % word_bits));
-            } else {
-                buf->content[y][word_n] |= 1 << (word_bits - x - 1 % word_bits);
+#if AESPL_GFX_C_MODE_MONO_EN
+        case AESPL_GFX_C_MODE_MONO: {
+            uint32_t bits = color ? 0xffffffff : 0;
+            int32_t first = x1 / 32, last = x2 / 32;
+            for (int32_t k = first; k <= last; k++) {
+                uint32_t mask = 0xffffffff;
+                if (k == first) {
+                    mask &= 0xffffffff >> (x1 % 32);
+                }
+                if (k == last) {
+                    mask &= 0xffffffff << (31 - x2 % 32);
+                }
+
+                uint32_t *w = &row[buf->wpr - 1 - k];
+                changed |= (*w ^ bits) & mask;
+                *w = (*w & ~mask) | (bits & mask);
             }
             break;
+        }
+#endif
 
-        case AESPL_GFX_C_MODE_RGB565:
-            buf->content[y][word_n] |= color << ((x % 2) ? 0 : 16);
+#if AESPL_GFX_C_MODE_RGB565_EN
+        case AESPL_GFX_C_MODE_RGB565: {
+            uint16_t *px = (uint16_t *)row;
+            uint16_t c = AESPL_GFX_RGB565_BE(color);
+
+            // Leftmost pixel shares a word with a pixel before the span
+            if (x1 % 2) {
+                changed |= px[x1] ^ c;
+                px[x1++] = c;
+            }
+
+            // Rightmost pixel shares a word with a pixel after the span
+            if (x1 <= x2 && !(x2 % 2)) {
+                changed |= px[x2] ^ c;
+                px[x2--] = c;
+            }
+
+            // Whole words in between
+            uint32_t pair = (uint32_t)c << 16 | c;
+            for (int32_t k = x1 / 2; k < (x2 + 1) / 2; k++) {
+                changed |= row[k] ^ pair;
+                row[k] = pair;
+            }
             break;
+        }
+#endif
 
+#if AESPL_GFX_C_MODE_ARGB888_EN
         case AESPL_GFX_C_MODE_ARGB888:
-            buf->content[y][word_n] = color;
+            for (int32_t k = x1; k <= x2; k++) {
+                uint32_t *w = &row[buf->wpr - 1 - k];
+                changed |= *w ^ color;
+                *w = color;
+            }
+            break;
+#endif
+
+        default:
             break;
     }
+
+    if (changed && buf->dirty) {
+        dirty_mark(buf, from, y, to, y);
+    }
 }
 
 uint32_t aespl_gfx_get_px(const aespl_gfx_buf_t *buf, int16_t x, int16_t y) {
@@ -165,22 +453,183 @@ uint32_t aespl_gfx_get_px(const aespl_gfx_buf_t *buf, int16_t x, int16_t y) {
         return 0x0;
     }
 
-    size_t word_bits = sizeof(**buf->content) * 8;
-    uint16_t word_n = buf->wpr - 1 - x / buf->ppw;
-    uint32_t w = buf->content[y][word_n];
+    return aespl_gfx_mode_get_px(buf->c_mode, buf, x, y);
+}
 
-    switch (buf->c_mode) {
-        case AESPL_GFX_C_MODE_MONO:
-            return 1 & (w >> (word_bits - x - 1 % word_bits));
+const uint8_t *aespl_gfx_get_rows_data(const aespl_gfx_buf_t *buf, int16_t y1,
+                                       int16_t y2, size_t *len) {
+    if (buf->c_mode != AESPL_GFX_C_MODE_RGB565 || y1 < 0 || y1 > y2 ||
+        y2 >= buf->height) {
+        return NULL;
+    }
 
-        case AESPL_GFX_C_MODE_RGB565:
-            return 0xffff & (w >> ((x % 2) ? 0 : 16));
+    // Padding pixels and separately allocated rows break the block
+    if (y1 != y2 &&
+        (buf->width % 2 || buf->storage == AESPL_GFX_BUF_STORAGE_ROWS)) {
+        return NULL;
+    }
 
-        case AESPL_GFX_C_MODE_ARGB888:
-            return w;
+    *len = (y2 - y1 + 1) * buf->width * sizeof(uint16_t);
+
+    return (const uint8_t *)buf->content[y1];
+}
+
+// Returns 32 MONO pixels of a row starting from position `pos`, leftmost
+// pixel in the most significant bit. Pixels outside of the row are zeros.
+static inline uint32_t mono_fetch(const uint32_t *row, uint16_t wpr,
+                                  int32_t pos) {
+    if (!row) {
+        return 0;
+    }
+
+    int32_t w = pos >= 0 ? pos / 32 : (pos - 31) / 32;  // floor division
+    uint8_t shift = pos - w * 32;
+
+    uint32_t hi = (w >= 0 && w < wpr) ? row[wpr - 1 - w] : 0;
+    if (!shift) {
+        return hi;
+    }
+
+    uint32_t lo = (w + 1 >= 0 && w + 1 < wpr) ? row[wpr - 2 - w] : 0;
+
+    return hi << shift | lo >> (32 - shift);
+}
+
+// Copies `w` MONO pixels from position `sx` of a source row to position `dx`
+// of a destination row. NULL source row means zeros. Set `rtl` when rows
+// overlap and the destination is to the right of the source.
+//
+// Returns whether the destination has changed.
+static bool mono_blit_row(uint32_t *dst, uint16_t dst_wpr, int32_t dx,
+                          const uint32_t *src, uint16_t src_wpr, int32_t sx,
+                          int32_t w, bool rtl) {
+    int32_t first = dx / 32, last = (dx + w - 1) / 32;
+    int32_t step = rtl ? -1 : 1;
+    uint32_t changed = 0;
+
+    for (int32_t k = rtl ? last : first; k >= first && k <= last; k += step) {
+        uint32_t bits = mono_fetch(src, src_wpr, sx + k * 32 - dx);
+        uint32_t mask = 0xffffffff;
+        if (k == first) {
+            mask &= 0xffffffff >> (dx % 32);
+        }
+        if (k == last) {
+            mask &= 0xffffffff << (31 - (dx + w - 1) % 32);
+        }
+
+        uint32_t *d = &dst[dst_wpr - 1 - k];
+        changed |= (*d ^ bits) & mask;
+        *d = (*d & ~mask) | (bits & mask);
+    }
+
+    return changed != 0;
+}
+
+// Copies `w` RGB565 or ARGB888 pixels from position `sx` of a source row to
+// position `dx` of a destination row. NULL source row means zeros.
+//
+// If `changed` is not NULL, it is set when the destination has changed.
+//
+// RGB565 rows are arrays of pixels. ARGB888 rows are arrays of pixels in
+// reverse order. Either way a run of pixels is a run of bytes.
+static void px_blit_row(uint32_t *dst, uint16_t dst_wpr, int32_t dx,
+                        const uint32_t *src, uint16_t src_wpr, int32_t sx,
+                        int32_t w, aespl_gfx_c_mode_t c_mode, bool *changed) {
+    bool reversed = c_mode != AESPL_GFX_C_MODE_RGB565;
+    size_t px_size = reversed ? sizeof(uint32_t) : sizeof(uint16_t);
+
+    // Pixels to the left of the source are zeros
+    int32_t n = 0;
+    if (!src || sx < 0) {
+        n = (!src || -sx > w) ? w : -sx;
+    }
+
+    size_t copy_size = (w - n) * px_size, zero_size = n * px_size;
+    uint8_t *d, *z;
+    const uint8_t *s = NULL;
+    if (reversed) {
+        // Copied pixels come first, zeros follow them
+        d = (uint8_t *)(dst + dst_wpr - dx - w);
+        z = d + copy_size;
+        if (n < w) {
+            s = (const uint8_t *)(src + src_wpr - sx - w);
+        }
+    } else {
+        z = (uint8_t *)dst + dx * px_size;
+        d = z + zero_size;
+        if (n < w) {
+            s = (const uint8_t *)src + (sx + n) * px_size;
+        }
+    }
+
+    if (changed) {
+        *changed = n < w && memcmp(d, s, copy_size);
+        for (size_t i = 0; !*changed && i < zero_size; i++) {
+            *changed = z[i] != 0;
+        }
+    }
+
+    // Copy first, the zeroed part may overlap the source
+    if (n < w) {
+        memmove(d, s, copy_size);
+    }
+    if (n) {
+        memset(z, 0, zero_size);
+    }
+}
+
+// Copies a row of pixels between buffers of different color modes, the row is
+// already clipped against the destination
+AESPL_GFX_PX_INLINE void convert_row(aespl_gfx_c_mode_t c_mode,
+                                     aespl_gfx_buf_t *dst, int32_t dx,
+                                     int32_t dy, const aespl_gfx_buf_t *src,
+                                     int32_t sx, int32_t sy, int32_t w,
+                                     bool *changed) {
+    for (int32_t c = 0; c < w; c++) {
+        uint32_t color = aespl_gfx_get_px(src, sx + c, sy);
+        *changed |= aespl_gfx_mode_set_px(c_mode, dst, dx + c, dy, color);
     }
+}
+
+// Copies a rectangle which is already clipped against the destination.
+// Source pixels outside of the source buffer are zeros.
+static void blit(aespl_gfx_buf_t *dst, int32_t dx, int32_t dy,
+                 const aespl_gfx_buf_t *src, int32_t sx, int32_t sy,
+                 int32_t w, int32_t h) {
+    bool overlap = dst == src;
+
+    // Walk rows backwards if the destination is below the source
+    int32_t r = 0, r_end = h, r_step = 1;
+    if (overlap && dy > sy) {
+        r = h - 1;
+        r_end = -1;
+        r_step = -1;
+    }
+
+    for (; r != r_end; r += r_step) {
+        uint32_t *d_row = dst->content[dy + r];
+        const uint32_t *s_row = NULL;
+        if (sy + r >= 0 && sy + r < src->height) {
+            s_row = src->content[sy + r];
+        }
 
-    return 0x0;
+        bool changed = false;
+        if (dst->c_mode != src->c_mode) {
+            // Slow path for different color modes
+            AESPL_GFX_DISPATCH(dst->c_mode, convert_row, dst, dx, dy + r, src,
+                               sx, sy + r, w, &changed);
+        } else if (dst->c_mode == AESPL_GFX_C_MODE_MONO) {
+            changed = mono_blit_row(d_row, dst->wpr, dx, s_row, src->wpr, sx, w,
+                                    overlap && sy + r == dy + r && dx > sx);
+        } else {
+            px_blit_row(d_row, dst->wpr, dx, s_row, src->wpr, sx, w,
+                        dst->c_mode, dst->dirty ? &changed : NULL);
+        }
+
+        if (changed && dst->dirty) {
+            dirty_mark(dst, dx, dy + r, dx + w - 1, dy + r);
+        }
+    }
 }
 
 aespl_gfx_err_t aespl_gfx_merge(aespl_gfx_buf_t *dst,
@@ -192,15 +641,29 @@ aespl_gfx_err_t aespl_gfx_merge(aespl_gfx_buf_t *dst,
         return AESPL_GFX_BAD_ARG;
     }
 
-    int16_t dst_x = dst_pos.x;
-    for (int16_t src_x = src_pos.x; src_x < src->width && dst_x < dst->width;
-         src_x++, dst_x++) {
-        int16_t dst_y = dst_pos.y;
-        for (int16_t src_y = src_pos.y;
-             src_y < src->height && dst_y < dst->height; src_y++, dst_y++) {
-            aespl_gfx_set_px(dst, dst_x, dst_y,
-                             aespl_gfx_get_px(src, src_x, src_y));
-        }
+    int32_t dx = dst_pos.x, dy = dst_pos.y, sx = src_pos.x, sy = src_pos.y;
+    int32_t w = src->width - sx, h = src->height - sy;
+
+    // Clip against the destination
+    if (dx < 0) {
+        sx -= dx;
+        w += dx;
+        dx = 0;
+    }
+    if (dy < 0) {
+        sy -= dy;
+        h += dy;
+        dy = 0;
+    }
+    if (dx + w > dst->width) {
+        w = dst->width - dx;
+    }
+    if (dy + h > dst->height) {
+        h = dst->height - dy;
+    }
+
+    if (w > 0 && h > 0) {
+        blit(dst, dx, dy, src, sx, sy, w, h);
     }
 
     return AESPL_GFX_OK;
@@ -233,28 +696,290 @@ aespl_gfx_buf_array_t *aespl_gfx_split(const aespl_gfx_buf_t *src,
     return dst;
 }
 
+// Reverses order of row pointers in range [from, to)
+static void reverse_rows(uint32_t **rows, uint16_t from, uint16_t to) {
+    while (from + 1 < to) {
+        uint32_t *tmp = rows[from];
+        rows[from++] = rows[--to];
+        rows[to] = tmp;
+    }
+}
+
+// Moves rows of a buffer by `n` rows down (or up if negative)
+static void move_rows(aespl_gfx_buf_t *buf, int32_t n) {
+    uint16_t n_abs = n < 0 ? -n : n;
+    uint16_t keep = buf->height - n_abs;
+    size_t row_size = buf->wpr * sizeof(**buf->content);
+
+    if (buf->storage != AESPL_GFX_BUF_STORAGE_ROWS) {
+        // Rows are adjacent, so move them all at once
+        uint8_t *px = (uint8_t *)buf->content[0];
+        if (n > 0) {
+            memmove(px + n_abs * row_size, px, keep * row_size);
+            memset(px, 0, n_abs * row_size);
+        } else {
+            memmove(px, px + n_abs * row_size, keep * row_size);
+            memset(px + keep * row_size, 0, n_abs * row_size);
+        }
+        return;
+    }
+
+    // Rotate pointers to rows
+    if (n > 0) {
+        reverse_rows(buf->content, 0, buf->height);
+        reverse_rows(buf->content, 0, n_abs);
+        reverse_rows(buf->content, n_abs, buf->height);
+    } else {
+        reverse_rows(buf->content, 0, n_abs);
+        reverse_rows(buf->content, n_abs, buf->height);
+        reverse_rows(buf->content, 0, buf->height);
+    }
+
+    // Clear rows which came around
+    uint16_t from = n > 0 ? 0 : keep;
+    for (uint16_t r = from; r < from + n_abs; r++) {
+        memset(buf->content[r], 0, row_size);
+    }
+}
+
+// Moves MONO pixels of a row by `n` pixels right (or left if negative)
+static void mono_move_row(uint32_t *row, uint16_t wpr, uint16_t width,
+                          int32_t n) {
+    uint16_t n_abs = n < 0 ? -n : n;
+    uint16_t q = n_abs / 32;
+    uint8_t b = n_abs % 32;
+
+    if (n > 0) {
+        // Moving right: pixels flow towards the beginning of the row
+        for (int32_t j = 0; j < wpr; j++) {
+            uint32_t hi = j + q < wpr ? row[j + q] : 0;
+            uint32_t carry = b && j + q + 1 < wpr ? row[j + q + 1] : 0;
+            row[j] = b ? hi >> b | carry << (32 - b) : hi;
+        }
+
+        // Pixels moved beyond the right edge must not stay in padding bits
+        row[0] &= 0xffffffff << (wpr * 32 - width);
+    } else {
+        // Moving left: pixels flow towards the end of the row
+        for (int32_t j = wpr - 1; j >= 0; j--) {
+            uint32_t lo = j - q >= 0 ? row[j - q] : 0;
+            uint32_t carry = b && j - q - 1 >= 0 ? row[j - q - 1] : 0;
+            row[j] = b ? lo << b | carry >> (32 - b) : lo;
+        }
+    }
+}
+
 aespl_gfx_err_t aespl_gfx_move(aespl_gfx_buf_t *buf, aespl_gfx_point_t pos) {
-    aespl_gfx_err_t err;
-    aespl_gfx_buf_t *tmp_buf =
-        aespl_gfx_make_buf(buf->width, buf->height, buf->c_mode);
-    if (!tmp_buf) {
-        return AESPL_GFX_FAIL;
+    // Whole content leaves the buffer
+    if (pos.x <= -buf->width || pos.x >= buf->width ||
+        pos.y <= -buf->height || pos.y >= buf->height) {
+        aespl_gfx_clear_buf(buf);
+        return AESPL_GFX_OK;
     }
 
-    err = aespl_gfx_merge(tmp_buf, buf, pos, (aespl_gfx_point_t){0, 0});
-    if (err) {
-        return err;
+    if ((pos.x || pos.y) && buf->dirty) {
+        dirty_mark(buf, 0, 0, buf->width - 1, buf->height - 1);
     }
 
-    aespl_gfx_clear_buf(buf);
+    if (pos.y) {
+        move_rows(buf, pos.y);
+    }
 
-    err = aespl_gfx_merge(buf, tmp_buf, (aespl_gfx_point_t){0, 0},
-                          (aespl_gfx_point_t){0, 0});
-    if (err) {
-        return err;
+    if (!pos.x) {
+        return AESPL_GFX_OK;
     }
 
-    aespl_gfx_free_buf(tmp_buf);
+    for (uint16_t r = 0; r < buf->height; r++) {
+        uint32_t *row = buf->content[r];
+
+        if (buf->c_mode == AESPL_GFX_C_MODE_MONO) {
+            mono_move_row(row, buf->wpr, buf->width, pos.x);
+        } else if (pos.x > 0) {
+            px_blit_row(row, buf->wpr, 0, row, buf->wpr, -pos.x, buf->width,
+                        buf->c_mode, NULL);
+        } else {
+            px_blit_row(row, buf->wpr, 0, row, buf->wpr, -pos.x,
+                        buf->width + pos.x, buf->c_mode, NULL);
+            px_blit_row(row, buf->wpr, buf->width + pos.x, NULL, 0, 0, -pos.x,
+                        buf->c_mode, NULL);
+        }
+    }
+
+    return AESPL_GFX_OK;
+}
+
+aespl_gfx_err_t aespl_gfx_track_dirty(aespl_gfx_buf_t *buf, bool enable) {
+    bool own_mem = buf->storage == AESPL_GFX_BUF_STORAGE_ROWS;
+
+    if (!enable) {
+        if (own_mem) {
+            free(buf->dirty);
+        }
+        buf->dirty = NULL;
+        return AESPL_GFX_OK;
+    }
+
+    if (!buf->dirty) {
+        if (own_mem) {
+            buf->dirty = malloc(dirty_size(buf->height));
+            if (!buf->dirty) {
+                return AESPL_GFX_NO_MEM;
+            }
+        } else {
+            // Single block buffers have room for it after row pointers
+            buf->dirty = (aespl_gfx_dirty_t *)(buf->content + buf->height);
+        }
+        buf->dirty->rows = (uint32_t *)(buf->dirty + 1);
+        aespl_gfx_reset_dirty(buf);
+    }
+
+    aespl_gfx_mark_dirty(buf, (aespl_gfx_point_t){0, 0},
+                         (aespl_gfx_point_t){buf->width - 1, buf->height - 1});
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_mark_dirty(aespl_gfx_buf_t *buf, aespl_gfx_point_t p1,
+                          aespl_gfx_point_t p2) {
+    if (!buf->dirty) {
+        return;
+    }
+
+    int32_t x1 = MAX(MIN(p1.x, p2.x), 0);
+    int32_t y1 = MAX(MIN(p1.y, p2.y), 0);
+    int32_t x2 = MIN(MAX(p1.x, p2.x), buf->width - 1);
+    int32_t y2 = MIN(MAX(p1.y, p2.y), buf->height - 1);
+
+    if (x1 <= x2 && y1 <= y2) {
+        dirty_mark(buf, x1, y1, x2, y2);
+    }
+}
+
+bool aespl_gfx_is_row_dirty(const aespl_gfx_buf_t *buf, int16_t y) {
+    if (y < 0 || y >= buf->height) {
+        return false;
+    }
+
+    if (!buf->dirty) {
+        return true;
+    }
+
+    return 1 & (buf->dirty->rows[y / 32] >> (y % 32));
+}
+
+bool aespl_gfx_get_dirty(const aespl_gfx_buf_t *buf, aespl_gfx_point_t *p1,
+                         aespl_gfx_point_t *p2) {
+    if (!buf->dirty) {
+        *p1 = (aespl_gfx_point_t){0, 0};
+        *p2 = (aespl_gfx_point_t){buf->width - 1, buf->height - 1};
+        return true;
+    }
+
+    *p1 = buf->dirty->p1;
+    *p2 = buf->dirty->p2;
+
+    return buf->dirty->is_dirty;
+}
+
+void aespl_gfx_reset_dirty(aespl_gfx_buf_t *buf) {
+    if (!buf->dirty) {
+        return;
+    }
+
+    buf->dirty->is_dirty = false;
+    memset(buf->dirty->rows, 0, (1 + buf->height / 32) * sizeof(uint32_t));
+}
+
+aespl_gfx_view_t aespl_gfx_make_view(aespl_gfx_buf_t *buf,
+                                     aespl_gfx_point_t pos, uint16_t width,
+                                     uint16_t height) {
+    return (aespl_gfx_view_t){buf, pos, width, height};
+}
+
+void aespl_gfx_view_set_px(const aespl_gfx_view_t *view, int16_t x, int16_t y,
+                           uint32_t color) {
+    if (x < 0 || x >= view->width || y < 0 || y >= view->height) {
+        return;
+    }
+
+    aespl_gfx_set_px(view->buf, view->pos.x + x, view->pos.y + y, color);
+}
+
+uint32_t aespl_gfx_view_get_px(const aespl_gfx_view_t *view, int16_t x,
+                               int16_t y) {
+    if (x < 0 || x >= view->width || y < 0 || y >= view->height) {
+        return 0x0;
+    }
+
+    return aespl_gfx_get_px(view->buf, view->pos.x + x, view->pos.y + y);
+}
+
+uint32_t aespl_gfx_view_get_word(const aespl_gfx_view_t *view, int16_t x,
+                                 int16_t y) {
+    const aespl_gfx_buf_t *buf = view->buf;
+    int32_t buf_y = view->pos.y + y;
+
+    if (buf->c_mode != AESPL_GFX_C_MODE_MONO || y < 0 || y >= view->height ||
+        buf_y < 0 || buf_y >= buf->height || x >= view->width || x <= -32) {
+        return 0x0;
+    }
+
+    uint32_t w = mono_fetch(buf->content[buf_y], buf->wpr, view->pos.x + x);
+
+    // Drop pixels to the left and to the right of the view
+    if (x < 0) {
+        w &= 0xffffffff >> -x;
+    }
+    if (view->width - x < 32) {
+        w &= ~(0xffffffff >> (view->width - x));
+    }
+
+    return w;
+}
+
+aespl_gfx_err_t aespl_gfx_merge_view(const aespl_gfx_view_t *dst,
+                                     const aespl_gfx_view_t *src,
+                                     aespl_gfx_point_t dst_pos) {
+    // Source rectangle relative to the source view, clipped by its buffer
+    int32_t x1 = 0, y1 = 0, x2 = src->width, y2 = src->height;
+    x1 = MAX(x1, -src->pos.x);
+    y1 = MAX(y1, -src->pos.y);
+    x2 = MIN(x2, src->buf->width - src->pos.x);
+    y2 = MIN(y2, src->buf->height - src->pos.y);
+
+    // Clip by the target view and its buffer
+    x1 = MAX(x1, -dst_pos.x);
+    y1 = MAX(y1, -dst_pos.y);
+    x2 = MIN(x2, dst->width - dst_pos.x);
+    y2 = MIN(y2, dst->height - dst_pos.y);
+    x1 = MAX(x1, -dst->pos.x - dst_pos.x);
+    y1 = MAX(y1, -dst->pos.y - dst_pos.y);
+    x2 = MIN(x2, dst->buf->width - dst->pos.x - dst_pos.x);
+    y2 = MIN(y2, dst->buf->height - dst->pos.y - dst_pos.y);
+
+    if (x1 < x2 && y1 < y2) {
+        blit(dst->buf, dst->pos.x + dst_pos.x + x1, dst->pos.y + dst_pos.y + y1,
+             src->buf, src->pos.x + x1, src->pos.y + y1, x2 - x1, y2 - y1);
+    }
+
+    return AESPL_GFX_OK;
+}
+
+aespl_gfx_err_t aespl_gfx_split_view(aespl_gfx_buf_t *src, uint8_t num_x,
+                                     uint8_t num_y, aespl_gfx_view_t *views) {
+    if (!num_x || !num_y) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    uint16_t width = src->width / num_x;
+    uint16_t height = src->height / num_y;
+
+    for (uint8_t n_y = 0; n_y < num_y; n_y++) {
+        for (uint8_t n_x = 0; n_x < num_x; n_x++) {
+            aespl_gfx_point_t pos = {n_x * width, n_y * height};
+            *views++ = aespl_gfx_make_view(src, pos, width, height);
+        }
+    }
 
     return AESPL_GFX_OK;
 }
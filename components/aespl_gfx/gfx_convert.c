@@ -0,0 +1,188 @@
+#include "aespl/gfx_convert.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_color.h"
+#include "aespl/gfx_px.h"
+
+// 4x4 Bayer matrix, thresholds are `16 * n + 8`
+static const uint8_t bayer[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+// Calculates brightness of a color row's pixels
+static void luma_row(const aespl_gfx_buf_t *src, uint16_t y, uint8_t *luma) {
+    if (src->c_mode == AESPL_GFX_C_MODE_RGB565) {
+        for (uint16_t x = 0; x < src->width; x++) {
+            uint16_t c = aespl_gfx_rgb565_get_px(src, x, y);
+            luma[x] = aespl_gfx_luma(aespl_gfx_rgb565_to_argb888(c));
+        }
+    } else {
+        for (uint16_t x = 0; x < src->width; x++) {
+            luma[x] = aespl_gfx_luma(aespl_gfx_argb888_get_px(src, x, y));
+        }
+    }
+}
+
+// Turns brightness of pixels into a MONO row, 32 pixels per store.
+//
+// Diffusion errors are kept multiplied by 16 and shifted by one pixel, so
+// that neighbours of the edge pixels need no checks.
+AESPL_GFX_PX_INLINE bool mono_row(aespl_gfx_dither_t dither,
+                                  aespl_gfx_buf_t *dst, uint16_t y,
+                                  const uint8_t *luma, int16_t *err,
+                                  int16_t *err_next) {
+    uint32_t *row = dst->content[y];
+    uint32_t word = 0, changed = 0;
+
+    for (uint16_t x = 0; x < dst->width; x++) {
+        bool on = false;
+
+        switch (dither) {
+            case AESPL_GFX_DITHER_NONE:
+                on = luma[x] >= 128;
+                break;
+
+            case AESPL_GFX_DITHER_ORDERED:
+                on = luma[x] >= bayer[y % 4][x % 4] * 16 + 8;
+                break;
+
+            case AESPL_GFX_DITHER_DIFFUSION: {
+                int16_t v = luma[x] + err[x + 1] / 16;
+                on = v >= 128;
+
+                int16_t e = v - (on ? 255 : 0);
+                err[x + 2] += e * 7;
+                err_next[x] += e * 3;
+                err_next[x + 1] += e * 5;
+                err_next[x + 2] += e;
+                break;
+            }
+        }
+
+        word |= (uint32_t)on << (31 - x % 32);
+
+        if (x % 32 == 31 || x == dst->width - 1) {
+            uint32_t *w = &row[dst->wpr - 1 - x / 32];
+            changed |= *w ^ word;
+            *w = word;
+            word = 0;
+        }
+    }
+
+    return changed != 0;
+}
+
+// Converts a row into an RGB565 or ARGB888 one
+AESPL_GFX_PX_INLINE void color_row(aespl_gfx_c_mode_t c_mode,
+                                   aespl_gfx_buf_t *dst,
+                                   const aespl_gfx_buf_t *src, uint16_t y,
+                                   bool *changed) {
+    uint32_t white = c_mode == AESPL_GFX_C_MODE_RGB565 ? 0xffff : 0xffffffff;
+    uint32_t black = c_mode == AESPL_GFX_C_MODE_RGB565 ? 0x0 : 0xff000000;
+
+    for (uint16_t x = 0; x < dst->width; x++) {
+        uint32_t c;
+        if (src->c_mode == AESPL_GFX_C_MODE_MONO) {
+            c = aespl_gfx_mono_get_px(src, x, y) ? white : black;
+        } else if (c_mode == AESPL_GFX_C_MODE_RGB565) {
+            c = aespl_gfx_argb888_get_px(src, x, y);
+            c = aespl_gfx_argb888_to_rgb565(c);
+        } else {
+            c = aespl_gfx_rgb565_get_px(src, x, y);
+            c = aespl_gfx_rgb565_to_argb888(c);
+        }
+
+        *changed |= aespl_gfx_mode_set_px(c_mode, dst, x, y, c);
+    }
+}
+
+static aespl_gfx_err_t convert_to_mono(aespl_gfx_buf_t *dst,
+                                       const aespl_gfx_buf_t *src,
+                                       aespl_gfx_dither_t dither) {
+    // Two rows of diffusion errors followed by a row of brightness
+    size_t n_err = dither == AESPL_GFX_DITHER_DIFFUSION ? dst->width + 2 : 0;
+    int16_t *mem = malloc(2 * n_err * sizeof(int16_t) + dst->width);
+    if (!mem) {
+        return AESPL_GFX_NO_MEM;
+    }
+    int16_t *err = mem, *err_next = mem + n_err;
+    uint8_t *luma = (uint8_t *)(err_next + n_err);
+    memset(err, 0, 2 * n_err * sizeof(int16_t));
+
+    for (uint16_t y = 0; y < dst->height; y++) {
+        bool changed = false;
+        luma_row(src, y, luma);
+
+        // Each dithering method gets its own copy of the loop
+        switch (dither) {
+            case AESPL_GFX_DITHER_NONE:
+                changed = mono_row(AESPL_GFX_DITHER_NONE, dst, y, luma, NULL,
+                                   NULL);
+                break;
+
+            case AESPL_GFX_DITHER_ORDERED:
+                changed = mono_row(AESPL_GFX_DITHER_ORDERED, dst, y, luma,
+                                   NULL, NULL);
+                break;
+
+            case AESPL_GFX_DITHER_DIFFUSION: {
+                changed = mono_row(AESPL_GFX_DITHER_DIFFUSION, dst, y, luma,
+                                   err, err_next);
+
+                // Errors of the next row become current ones
+                int16_t *tmp = err;
+                err = err_next;
+                err_next = tmp;
+                memset(err_next, 0, n_err * sizeof(int16_t));
+                break;
+            }
+        }
+
+        if (changed) {
+            aespl_gfx_mark_dirty(dst, (aespl_gfx_point_t){0, y},
+                                 (aespl_gfx_point_t){dst->width - 1, y});
+        }
+    }
+
+    free(mem);
+
+    return AESPL_GFX_OK;
+}
+
+aespl_gfx_err_t aespl_gfx_convert(aespl_gfx_buf_t *dst,
+                                  const aespl_gfx_buf_t *src,
+                                  aespl_gfx_dither_t dither) {
+    if (dst->width != src->width || dst->height != src->height ||
+        dither > AESPL_GFX_DITHER_DIFFUSION) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    if (dst->c_mode == src->c_mode) {
+        aespl_gfx_point_t zero = {0, 0};
+        return aespl_gfx_merge(dst, src, zero, zero);
+    }
+
+    if (dst->c_mode == AESPL_GFX_C_MODE_MONO) {
+        return convert_to_mono(dst, src, dither);
+    }
+
+    for (uint16_t y = 0; y < dst->height; y++) {
+        bool changed = false;
+        AESPL_GFX_DISPATCH(dst->c_mode, color_row, dst, src, y, &changed);
+
+        if (changed) {
+            aespl_gfx_mark_dirty(dst, (aespl_gfx_point_t){0, y},
+                                 (aespl_gfx_point_t){dst->width - 1, y});
+        }
+    }
+
+    return AESPL_GFX_OK;
+}
@@ -1,47 +1,152 @@
 #include "aespl/gfx_geometry.h"
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "aespl/gfx_buffer.h"
+#include "aespl/gfx_px.h"
 
-void aespl_gfx_line(aespl_gfx_buf_t *buf, const aespl_gfx_line_t *line,
-                    uint32_t color) {
-    uint16_t x1 = line->p1.x, x2 = line->p2.x, y1 = line->p1.y, y2 = line->p2.y;
+// Cohen-Sutherland region codes
+#define OUT_LEFT 0x1
+#define OUT_RIGHT 0x2
+#define OUT_TOP 0x4
+#define OUT_BOTTOM 0x8
 
-    if (x2 >= buf->width) {
-        x2 = buf->width - 1;
+// Integer division rounded to the nearest integer, `b` must not be zero
+static int64_t div_round(int64_t a, int64_t b) {
+    // Lines going up or to the left have negative deltas
+    if (b < 0) {
+        a = -a;
+        b = -b;
     }
-    if (y2 >= buf->height) {
-        y2 = buf->height - 1;
+
+    return a >= 0 ? (a + b / 2) / b : -((-a + b / 2) / b);
+}
+
+static uint8_t out_code(const aespl_gfx_buf_t *buf, aespl_gfx_point_t p) {
+    uint8_t code = 0;
+
+    if (p.x < 0) {
+        code |= OUT_LEFT;
+    } else if (p.x >= buf->width) {
+        code |= OUT_RIGHT;
     }
 
-    float x = x1, y = y1, dx = x2 - x1, dy = y2 - y1;
-    uint16_t step, abs_dx = abs(dx), abs_dy = abs(dy);
+    if (p.y < 0) {
+        code |= OUT_TOP;
+    } else if (p.y >= buf->height) {
+        code |= OUT_BOTTOM;
+    }
 
-    step = abs_dx >= abs_dy ? abs_dx : abs_dy;
-    dx /= step;
-    dy /= step;
+    return code;
+}
 
-    uint16_t i = 0;
-    while (i <= step) {
-        if (i == step) {
-            if (x < x2) {
-                x = x2;
-            }
-            if (y < y2) {
-                y = y2;
+// Clips a line by buffer's boundaries, returns false if nothing is left
+static bool clip_line(const aespl_gfx_buf_t *buf, aespl_gfx_point_t *p1,
+                      aespl_gfx_point_t *p2) {
+    uint8_t c1 = out_code(buf, *p1), c2 = out_code(buf, *p2);
+
+    while (c1 | c2) {
+        // Both points are on the same outer side
+        if (c1 & c2) {
+            return false;
+        }
+
+        // Move the outer point to the boundary it crosses
+        aespl_gfx_point_t *p = c1 ? p1 : p2;
+        uint8_t c = c1 ? c1 : c2;
+        int64_t dx = p2->x - p1->x, dy = p2->y - p1->y;
+        int32_t x, y;
+
+        if (c & OUT_TOP) {
+            y = 0;
+            x = p1->x + div_round(dx * (y - p1->y), dy);
+        } else if (c & OUT_BOTTOM) {
+            y = buf->height - 1;
+            x = p1->x + div_round(dx * (y - p1->y), dy);
+        } else if (c & OUT_LEFT) {
+            x = 0;
+            y = p1->y + div_round(dy * (x - p1->x), dx);
+        } else {
+            x = buf->width - 1;
+            y = p1->y + div_round(dy * (x - p1->x), dx);
+        }
+
+        *p = (aespl_gfx_point_t){x, y};
+        if (p == p1) {
+            c1 = out_code(buf, *p1);
+        } else {
+            c2 = out_code(buf, *p2);
+        }
+    }
+
+    return true;
+}
+
+// Bresenham's algorithm for a line which is already clipped against the buffer
+AESPL_GFX_PX_INLINE void bresenham(aespl_gfx_c_mode_t c_mode,
+                                   aespl_gfx_buf_t *buf, aespl_gfx_point_t p1,
+                                   aespl_gfx_point_t p2, uint32_t color) {
+    int32_t dx = abs(p2.x - p1.x), sx = p1.x < p2.x ? 1 : -1;
+    int32_t dy = -abs(p2.y - p1.y), sy = p1.y < p2.y ? 1 : -1;
+    int32_t err = dx + dy;
+
+    // The line is monotonic, so changed pixels are bounded by the first and
+    // the last of them
+    bool changed = false;
+    aespl_gfx_point_t first = p1, last = p1;
+
+    for (;;) {
+        if (aespl_gfx_mode_set_px(c_mode, buf, p1.x, p1.y, color)) {
+            if (!changed) {
+                first = p1;
+                changed = true;
             }
+            last = p1;
         }
 
-        aespl_gfx_set_px(buf, abs(x), abs(y), color);
+        if (p1.x == p2.x && p1.y == p2.y) {
+            break;
+        }
 
-        x += dx;
-        y += dy;
+        int32_t e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            p1.x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            p1.y += sy;
+        }
+    }
 
-        ++i;
+    if (changed) {
+        aespl_gfx_mark_dirty(buf, first, last);
     }
 }
 
+void aespl_gfx_line(aespl_gfx_buf_t *buf, const aespl_gfx_line_t *line,
+                    uint32_t color) {
+    aespl_gfx_point_t p1 = line->p1, p2 = line->p2;
+
+    if (!clip_line(buf, &p1, &p2)) {
+        return;
+    }
+
+    // Horizontal and vertical lines are filled by spans
+    if (p1.y == p2.y) {
+        aespl_gfx_fill_span(buf, p1.y, p1.x, p2.x, color);
+        return;
+    }
+    if (p1.x == p2.x) {
+        aespl_gfx_fill_rect(buf, p1, p2, color);
+        return;
+    }
+
+    AESPL_GFX_DISPATCH(buf->c_mode, bresenham, buf, p1, p2, color);
+}
+
 void aespl_gfx_poly(aespl_gfx_buf_t *buf, const aespl_gfx_poly_t *poly,
                     uint32_t color) {
     aespl_gfx_line_t l;
@@ -75,3 +180,317 @@ void aespl_gfx_tri(aespl_gfx_buf_t *buf, const aespl_gfx_point_t p1,
     aespl_gfx_point_t points[3] = {p1, p2, p3};
     aespl_gfx_poly(buf, &((aespl_gfx_poly_t){3, points}), color);
 }
+
+void aespl_gfx_hline(aespl_gfx_buf_t *buf, aespl_gfx_point_t p, uint16_t len,
+                     uint32_t color) {
+    if (len && p.y >= 0 && p.y < buf->height) {
+        aespl_gfx_fill_span(buf, p.y, p.x, p.x + len - 1, color);
+    }
+}
+
+void aespl_gfx_vline(aespl_gfx_buf_t *buf, aespl_gfx_point_t p, uint16_t len,
+                     uint32_t color) {
+    if (len) {
+        aespl_gfx_fill_rect(buf, p, (aespl_gfx_point_t){p.x, p.y + len - 1},
+                            color);
+    }
+}
+
+void aespl_gfx_fill_rect(aespl_gfx_buf_t *buf, aespl_gfx_point_t p1,
+                         aespl_gfx_point_t p2, uint32_t color) {
+    int32_t y1 = p1.y < p2.y ? p1.y : p2.y;
+    int32_t y2 = p1.y < p2.y ? p2.y : p1.y;
+
+    if (y1 < 0) {
+        y1 = 0;
+    }
+    if (y2 >= buf->height) {
+        y2 = buf->height - 1;
+    }
+
+    for (int32_t y = y1; y <= y2; y++) {
+        aespl_gfx_fill_span(buf, y, p1.x, p2.x, color);
+    }
+}
+
+void aespl_gfx_fill_poly(aespl_gfx_buf_t *buf, const aespl_gfx_poly_t *poly,
+                         uint32_t color) {
+    uint8_t n = poly->n_corners;
+    if (n < 3) {
+        aespl_gfx_poly(buf, poly, color);
+        return;
+    }
+
+    // Vertical extent clipped by the buffer
+    int32_t y_min = poly->corners[0].y, y_max = poly->corners[0].y;
+    for (uint8_t i = 1; i < n; i++) {
+        y_min = poly->corners[i].y < y_min ? poly->corners[i].y : y_min;
+        y_max = poly->corners[i].y > y_max ? poly->corners[i].y : y_max;
+    }
+    if (y_min < 0) {
+        y_min = 0;
+    }
+    if (y_max >= buf->height) {
+        y_max = buf->height - 1;
+    }
+
+    // Each scanline crosses every edge at most once
+    int16_t xs[n];
+
+    for (int32_t y = y_min; y <= y_max; y++) {
+        uint8_t n_xs = 0;
+
+        for (uint8_t i = 0; i < n; i++) {
+            aespl_gfx_point_t a = poly->corners[i];
+            aespl_gfx_point_t b = poly->corners[(i + 1) % n];
+            if (a.y > b.y) {
+                aespl_gfx_point_t tmp = a;
+                a = b;
+                b = tmp;
+            }
+
+            // Edges include their top end only, so shared corners count once
+            if (y < a.y || y >= b.y) {
+                continue;
+            }
+
+            int32_t x = a.x + div_round((y - a.y) * (b.x - a.x), b.y - a.y);
+            if (x < -1) {
+                x = -1;
+            } else if (x > buf->width) {
+                x = buf->width;
+            }
+
+            // Insertion sort
+            uint8_t j = n_xs++;
+            for (; j > 0 && xs[j - 1] > x; j--) {
+                xs[j] = xs[j - 1];
+            }
+            xs[j] = x;
+        }
+
+        for (uint8_t i = 0; i + 1 < n_xs; i += 2) {
+            aespl_gfx_fill_span(buf, y, xs[i], xs[i + 1], color);
+        }
+    }
+
+    // Bottom edges are not covered by scanlines
+    aespl_gfx_poly(buf, poly, color);
+}
+
+void aespl_gfx_fill_tri(aespl_gfx_buf_t *buf, const aespl_gfx_point_t p1,
+                        const aespl_gfx_point_t p2, const aespl_gfx_point_t p3,
+                        uint32_t color) {
+    aespl_gfx_point_t points[3] = {p1, p2, p3};
+    aespl_gfx_fill_poly(buf, &((aespl_gfx_poly_t){3, points}), color);
+}
+
+// Sine of 0..90 degrees multiplied by AESPL_GFX_TRIG_ONE
+static const int16_t sin_lut[91] = {
+    0,     286,   572,   857,   1143,  1428,  1713,  1997,  2280,  2563,
+    2845,  3126,  3406,  3686,  3964,  4240,  4516,  4790,  5063,  5334,
+    5604,  5872,  6138,  6402,  6664,  6924,  7182,  7438,  7692,  7943,
+    8192,  8438,  8682,  8923,  9162,  9397,  9630,  9860,  10087, 10311,
+    10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+    12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+    14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+    15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+    16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+    16384,
+};
+
+int16_t aespl_gfx_sin(int32_t deg) {
+    deg %= 360;
+    if (deg < 0) {
+        deg += 360;
+    }
+
+    if (deg <= 90) {
+        return sin_lut[deg];
+    } else if (deg <= 180) {
+        return sin_lut[180 - deg];
+    } else if (deg <= 270) {
+        return -sin_lut[deg - 180];
+    }
+
+    return -sin_lut[360 - deg];
+}
+
+int16_t aespl_gfx_cos(int32_t deg) {
+    return aespl_gfx_sin(deg + 90);
+}
+
+// Draws pixels of all eight octants
+static void circle_px8(aespl_gfx_buf_t *buf, aespl_gfx_point_t c, int32_t x,
+                       int32_t y, uint32_t color) {
+    aespl_gfx_set_px(buf, c.x + x, c.y + y, color);
+    aespl_gfx_set_px(buf, c.x - x, c.y + y, color);
+    aespl_gfx_set_px(buf, c.x + x, c.y - y, color);
+    aespl_gfx_set_px(buf, c.x - x, c.y - y, color);
+    aespl_gfx_set_px(buf, c.x + y, c.y + x, color);
+    aespl_gfx_set_px(buf, c.x - y, c.y + x, color);
+    aespl_gfx_set_px(buf, c.x + y, c.y - x, color);
+    aespl_gfx_set_px(buf, c.x - y, c.y - x, color);
+}
+
+// Fills spans of the rows `dy` above and below the center
+static void fill_row_pair(aespl_gfx_buf_t *buf, aespl_gfx_point_t c,
+                          int32_t dy, int32_t half_w, uint32_t color) {
+    aespl_gfx_fill_span(buf, c.y + dy, c.x - half_w, c.x + half_w, color);
+    if (dy) {
+        aespl_gfx_fill_span(buf, c.y - dy, c.x - half_w, c.x + half_w, color);
+    }
+}
+
+// Walks the first octant of a circle using the midpoint algorithm
+static void circle_walk(aespl_gfx_buf_t *buf, aespl_gfx_point_t c, uint16_t r,
+                        uint32_t color,
+                        void (*draw)(aespl_gfx_buf_t *, aespl_gfx_point_t,
+                                     int32_t, int32_t, uint32_t)) {
+    int32_t x = r, y = 0, err = 1 - r;
+
+    while (x >= y) {
+        draw(buf, c, x, y, color);
+
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void aespl_gfx_circle(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                      uint16_t r, uint32_t color) {
+    circle_walk(buf, center, r, color, circle_px8);
+}
+
+void aespl_gfx_fill_circle(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                           uint16_t r, uint32_t color) {
+    int32_t x = r, y = 0, err = 1 - r;
+
+    // Each row is filled once: rows `y` away from the center as they are met,
+    // rows `x` away when they are the widest, that is before `x` changes
+    while (x >= y) {
+        fill_row_pair(buf, center, y, x, color);
+
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            if (x >= y) {
+                fill_row_pair(buf, center, x, y - 1, color);
+            }
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// Walks a quadrant of an ellipse using integer error terms, draws either
+// the outline or spans of all four quadrants
+static void ellipse_walk(aespl_gfx_buf_t *buf, aespl_gfx_point_t c,
+                         uint16_t rx, uint16_t ry, uint32_t color, bool fill) {
+    int64_t a2 = (int64_t)rx * rx, b2 = (int64_t)ry * ry;
+    int32_t x = -rx, y = 0, filled_y = -1;
+    int64_t err = x * (2 * b2 + x) + b2, e2;
+
+    do {
+        if (fill) {
+            // A row is the widest when it is met first
+            if (y != filled_y) {
+                fill_row_pair(buf, c, y, -x, color);
+                filled_y = y;
+            }
+        } else {
+            aespl_gfx_set_px(buf, c.x - x, c.y + y, color);
+            aespl_gfx_set_px(buf, c.x + x, c.y + y, color);
+            aespl_gfx_set_px(buf, c.x + x, c.y - y, color);
+            aespl_gfx_set_px(buf, c.x - x, c.y - y, color);
+        }
+
+        e2 = 2 * err;
+        if (e2 >= (x * 2 + 1) * b2) {
+            x++;
+            err += (x * 2 + 1) * b2;
+        }
+        if (e2 <= (y * 2 + 1) * a2) {
+            y++;
+            err += (y * 2 + 1) * a2;
+        }
+    } while (x <= 0);
+
+    // Flat ellipses finish with tips
+    while (y++ < ry) {
+        aespl_gfx_set_px(buf, c.x, c.y + y, color);
+        aespl_gfx_set_px(buf, c.x, c.y - y, color);
+    }
+}
+
+void aespl_gfx_ellipse(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                       uint16_t rx, uint16_t ry, uint32_t color) {
+    ellipse_walk(buf, center, rx, ry, color, false);
+}
+
+void aespl_gfx_fill_ellipse(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                            uint16_t rx, uint16_t ry, uint32_t color) {
+    ellipse_walk(buf, center, rx, ry, color, true);
+}
+
+void aespl_gfx_arc(aespl_gfx_buf_t *buf, aespl_gfx_point_t center, uint16_t r,
+                   int32_t start, int32_t end, uint32_t color) {
+    if (end - start >= 360) {
+        aespl_gfx_circle(buf, center, r, color);
+        return;
+    }
+
+    int32_t span = (end - start) % 360;
+    if (span < 0) {
+        span += 360;
+    }
+    if (!span) {
+        return;
+    }
+
+    // Direction vectors of arc's ends
+    int32_t s_x = aespl_gfx_cos(start), s_y = aespl_gfx_sin(start);
+    int32_t e_x = aespl_gfx_cos(end), e_y = aespl_gfx_sin(end);
+
+    int32_t x = r, y = 0, err = 1 - r;
+    while (x >= y) {
+        // Eight symmetric points
+        int32_t pts[8][2] = {
+            {x, y},  {y, x},  {-y, x},  {-x, y},
+            {-x, -y}, {-y, -x}, {y, -x}, {x, -y},
+        };
+
+        for (uint8_t i = 0; i < 8; i++) {
+            int32_t px = pts[i][0], py = pts[i][1];
+
+            // Cross products tell on which side of arc's ends the point is
+            int32_t after_start = s_x * py - s_y * px;
+            int32_t before_end = px * e_y - py * e_x;
+
+            bool in_arc;
+            if (span <= 180) {
+                in_arc = after_start >= 0 && before_end >= 0;
+            } else {
+                in_arc = after_start >= 0 || before_end >= 0;
+            }
+
+            if (in_arc) {
+                aespl_gfx_set_px(buf, center.x + px, center.y + py, color);
+            }
+        }
+
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
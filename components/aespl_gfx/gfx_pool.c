@@ -0,0 +1,121 @@
+#include "aespl/gfx_pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aespl/gfx_buffer.h"
+
+aespl_gfx_err_t aespl_gfx_pool_init(aespl_gfx_pool_t *pool, void *mem,
+                                    size_t size) {
+    memset(pool, 0, sizeof(*pool));
+
+    if (!mem) {
+        mem = malloc(size);
+        if (!mem) {
+            return AESPL_GFX_NO_MEM;
+        }
+        pool->own_mem = true;
+    }
+
+    pool->mem = mem;
+    pool->size = size;
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_pool_deinit(aespl_gfx_pool_t *pool) {
+    if (pool->own_mem) {
+        free(pool->mem);
+    }
+
+    memset(pool, 0, sizeof(*pool));
+}
+
+void *aespl_gfx_pool_alloc(aespl_gfx_pool_t *pool, size_t size) {
+    // Keep allocations word-aligned
+    size = (size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+
+    if (size > pool->size - pool->used) {
+        pool->n_fails++;
+        return NULL;
+    }
+
+    void *mem = pool->mem + pool->used;
+    pool->used += size;
+
+    if (pool->used > pool->high_water) {
+        pool->high_water = pool->used;
+    }
+
+    return mem;
+}
+
+size_t aespl_gfx_pool_mark(const aespl_gfx_pool_t *pool) {
+    return pool->used;
+}
+
+void aespl_gfx_pool_release(aespl_gfx_pool_t *pool, size_t mark) {
+    if (mark < pool->used) {
+        pool->used = mark;
+    }
+}
+
+void aespl_gfx_pool_reset(aespl_gfx_pool_t *pool) {
+    pool->used = 0;
+}
+
+aespl_gfx_buf_t *aespl_gfx_pool_make_buf(aespl_gfx_pool_t *pool,
+                                         uint16_t width, uint16_t height,
+                                         aespl_gfx_c_mode_t c_mode) {
+    void *mem =
+        aespl_gfx_pool_alloc(pool, aespl_gfx_buf_size(width, height, c_mode));
+    if (!mem) {
+        return NULL;
+    }
+
+    return aespl_gfx_init_buf(mem, width, height, c_mode);
+}
+
+aespl_gfx_buf_array_t *aespl_gfx_pool_make_buf_array(aespl_gfx_pool_t *pool,
+                                                     uint8_t length,
+                                                     uint16_t width,
+                                                     uint16_t height,
+                                                     aespl_gfx_c_mode_t c_mode) {
+    void *mem = aespl_gfx_pool_alloc(
+        pool, aespl_gfx_buf_array_size(length, width, height, c_mode));
+    if (!mem) {
+        return NULL;
+    }
+
+    return aespl_gfx_init_buf_array(mem, length, width, height, c_mode);
+}
+
+aespl_gfx_buf_array_t *aespl_gfx_pool_split(aespl_gfx_pool_t *pool,
+                                            const aespl_gfx_buf_t *src,
+                                            uint8_t num_x, uint8_t num_y) {
+    uint16_t dst_width = src->width / num_x;
+    uint16_t dst_height = src->height / num_y;
+
+    size_t mark = aespl_gfx_pool_mark(pool);
+    aespl_gfx_buf_array_t *dst = aespl_gfx_pool_make_buf_array(
+        pool, num_x * num_y, dst_width, dst_height, src->c_mode);
+    if (!dst) {
+        return NULL;
+    }
+
+    uint8_t i = 0;
+    for (uint8_t n_y = 0; n_y < num_y; n_y++) {
+        for (uint8_t n_x = 0; n_x < num_x; n_x++) {
+            aespl_gfx_point_t src_pos = {n_x * dst_width, n_y * dst_height};
+            if (aespl_gfx_merge(dst->buffers[i], src, (aespl_gfx_point_t){0, 0},
+                                src_pos) != AESPL_GFX_OK) {
+                aespl_gfx_pool_release(pool, mark);
+                return NULL;
+            }
+            i++;
+        }
+    }
+
+    return dst;
+}
@@ -0,0 +1,400 @@
+#include "aespl/gfx_sprite.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_px.h"
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+// Frame of a sprite, NULL if the sheet has no such frame
+static inline const aespl_gfx_sprite_frame_t *get_frame(
+    const aespl_gfx_sprite_t *sprite, uint16_t frame) {
+    if (frame >= sprite->sheet->n_frames) {
+        return NULL;
+    }
+
+    return &sprite->sheet->frames[frame];
+}
+
+static inline aespl_gfx_view_t frame_mask(const aespl_gfx_sprite_t *sprite,
+                                          const aespl_gfx_sprite_frame_t *f) {
+    return aespl_gfx_make_view(sprite->sheet->mask, f->pos, f->width,
+                               f->height);
+}
+
+// Adds a rectangle to the parts of rows to composite
+static void damage(aespl_gfx_sprite_layer_t *layer, aespl_gfx_point_t pos,
+                   const aespl_gfx_sprite_frame_t *f) {
+    int32_t x1 = MAX(pos.x, 0);
+    int32_t x2 = MIN(pos.x + f->width - 1, layer->width - 1);
+    int32_t y1 = MAX(pos.y, 0);
+    int32_t y2 = MIN(pos.y + f->height - 1, layer->height - 1);
+
+    if (x1 > x2) {
+        return;
+    }
+
+    for (int32_t y = y1; y <= y2; y++) {
+        aespl_gfx_sprite_span_t *span = &layer->spans[y];
+        span->x1 = MIN(span->x1, x1);
+        span->x2 = MAX(span->x2, x2);
+    }
+}
+
+aespl_gfx_err_t aespl_gfx_sprite_sheet_init(
+    aespl_gfx_sprite_sheet_t *sheet, aespl_gfx_buf_t *buf,
+    const aespl_gfx_sprite_frame_t *frames, uint16_t n_frames) {
+    for (uint16_t i = 0; i < n_frames; i++) {
+        const aespl_gfx_sprite_frame_t *f = &frames[i];
+        if (f->pos.x < 0 || f->pos.y < 0 || f->pos.x + f->width > buf->width ||
+            f->pos.y + f->height > buf->height) {
+            return AESPL_GFX_BAD_ARG;
+        }
+    }
+
+    memset(sheet, 0, sizeof(*sheet));
+    sheet->buf = buf;
+    sheet->frames = frames;
+    sheet->n_frames = n_frames;
+
+    if (buf->c_mode == AESPL_GFX_C_MODE_MONO) {
+        sheet->mask = buf;
+        return AESPL_GFX_OK;
+    }
+
+    sheet->mask = aespl_gfx_make_buf(buf->width, buf->height,
+                                     AESPL_GFX_C_MODE_MONO);
+    if (!sheet->mask) {
+        return AESPL_GFX_NO_MEM;
+    }
+
+    for (uint16_t y = 0; y < buf->height; y++) {
+        for (uint16_t x = 0; x < buf->width; x++) {
+            if (aespl_gfx_mode_get_px(buf->c_mode, buf, x, y)) {
+                aespl_gfx_mono_set_px(sheet->mask, x, y, 1);
+            }
+        }
+    }
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_sprite_sheet_deinit(aespl_gfx_sprite_sheet_t *sheet) {
+    if (sheet->mask && sheet->mask != sheet->buf) {
+        aespl_gfx_free_buf(sheet->mask);
+    }
+
+    sheet->mask = NULL;
+}
+
+void aespl_gfx_sprite_init(aespl_gfx_sprite_t *sprite,
+                           const aespl_gfx_sprite_sheet_t *sheet) {
+    memset(sprite, 0, sizeof(*sprite));
+    sprite->sheet = sheet;
+    sprite->visible = true;
+}
+
+bool aespl_gfx_sprite_collide(const aespl_gfx_sprite_t *a,
+                              const aespl_gfx_sprite_t *b) {
+    if (a == b || !a->visible || !b->visible) {
+        return false;
+    }
+
+    const aespl_gfx_sprite_frame_t *fa = get_frame(a, a->frame);
+    const aespl_gfx_sprite_frame_t *fb = get_frame(b, b->frame);
+    if (!fa || !fb) {
+        return false;
+    }
+
+    // Overlapping rectangle, the right and the bottom edges are exclusive
+    int32_t x1 = MAX(a->pos.x, b->pos.x);
+    int32_t y1 = MAX(a->pos.y, b->pos.y);
+    int32_t x2 = MIN(a->pos.x + fa->width, b->pos.x + fb->width);
+    int32_t y2 = MIN(a->pos.y + fa->height, b->pos.y + fb->height);
+
+    aespl_gfx_view_t ma = frame_mask(a, fa), mb = frame_mask(b, fb);
+
+    // Pixels beyond the overlap are outside one of the masks, so they are
+    // zeros and need no clipping
+    for (int32_t y = y1; y < y2; y++) {
+        for (int32_t x = x1; x < x2; x += 32) {
+            uint32_t wa = aespl_gfx_view_get_word(&ma, x - a->pos.x,
+                                                  y - a->pos.y);
+            uint32_t wb = aespl_gfx_view_get_word(&mb, x - b->pos.x,
+                                                  y - b->pos.y);
+            if (wa & wb) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+aespl_gfx_err_t aespl_gfx_sprite_layer_init(aespl_gfx_sprite_layer_t *layer,
+                                            uint16_t width, uint16_t height,
+                                            aespl_gfx_c_mode_t c_mode,
+                                            aespl_gfx_buf_t *bg) {
+    if (!width || !height ||
+        (bg && (bg->width != width || bg->height != height))) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    memset(layer, 0, sizeof(*layer));
+    layer->width = width;
+    layer->height = height;
+    layer->c_mode = c_mode;
+    layer->bg = bg;
+
+    layer->spans = malloc(height * sizeof(aespl_gfx_sprite_span_t));
+    layer->row = aespl_gfx_make_buf(width, 1, c_mode);
+    if (!layer->spans || !layer->row) {
+        aespl_gfx_sprite_layer_deinit(layer);
+        return AESPL_GFX_NO_MEM;
+    }
+
+    // The target's content is unknown
+    aespl_gfx_sprite_layer_invalidate(layer);
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_sprite_layer_deinit(aespl_gfx_sprite_layer_t *layer) {
+    if (layer->row) {
+        aespl_gfx_free_buf(layer->row);
+        layer->row = NULL;
+    }
+
+    free(layer->spans);
+    layer->spans = NULL;
+    layer->sprites = NULL;
+}
+
+aespl_gfx_err_t aespl_gfx_sprite_layer_add(aespl_gfx_sprite_layer_t *layer,
+                                           aespl_gfx_sprite_t *sprite) {
+    if (sprite->sheet->buf->c_mode != layer->c_mode) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    // Sprites of the same z-order keep the order they were added in
+    aespl_gfx_sprite_t **p = &layer->sprites;
+    while (*p && (*p)->z <= sprite->z) {
+        p = &(*p)->next;
+    }
+    sprite->next = *p;
+    *p = sprite;
+
+    sprite->drawn = false;
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_sprite_layer_remove(aespl_gfx_sprite_layer_t *layer,
+                                   aespl_gfx_sprite_t *sprite) {
+    for (aespl_gfx_sprite_t **p = &layer->sprites; *p; p = &(*p)->next) {
+        if (*p != sprite) {
+            continue;
+        }
+
+        *p = sprite->next;
+        sprite->next = NULL;
+
+        if (sprite->drawn) {
+            damage(layer, sprite->drawn_pos,
+                   get_frame(sprite, sprite->drawn_frame));
+            sprite->drawn = false;
+        }
+
+        return;
+    }
+}
+
+void aespl_gfx_sprite_layer_invalidate(aespl_gfx_sprite_layer_t *layer) {
+    for (uint16_t y = 0; y < layer->height; y++) {
+        layer->spans[y] = (aespl_gfx_sprite_span_t){0, layer->width - 1};
+    }
+}
+
+aespl_gfx_sprite_t *aespl_gfx_sprite_layer_collide(
+    const aespl_gfx_sprite_layer_t *layer, const aespl_gfx_sprite_t *sprite) {
+    for (aespl_gfx_sprite_t *s = layer->sprites; s; s = s->next) {
+        if (aespl_gfx_sprite_collide(s, sprite)) {
+            return s;
+        }
+    }
+
+    return NULL;
+}
+
+// Restores the z-order after sprites' z has been changed. Insertion sort is
+// stable and takes a single pass over an already sorted list.
+static void sort_sprites(aespl_gfx_sprite_layer_t *layer) {
+    aespl_gfx_sprite_t *sorted = NULL, *last = NULL, *next;
+
+    for (aespl_gfx_sprite_t *s = layer->sprites; s; s = next) {
+        next = s->next;
+        s->next = NULL;
+
+        // Usually the sprite goes after the last sorted one
+        if (!last || last->z <= s->z) {
+            if (last) {
+                last->next = s;
+            } else {
+                sorted = s;
+            }
+            last = s;
+            continue;
+        }
+
+        aespl_gfx_sprite_t **p = &sorted;
+        while ((*p)->z <= s->z) {
+            p = &(*p)->next;
+        }
+        s->next = *p;
+        *p = s;
+    }
+
+    layer->sprites = sorted;
+}
+
+// Damages both old and new places of sprites which have changed
+static void damage_changes(aespl_gfx_sprite_layer_t *layer) {
+    for (aespl_gfx_sprite_t *s = layer->sprites; s; s = s->next) {
+        const aespl_gfx_sprite_frame_t *f = NULL;
+        if (s->visible) {
+            f = get_frame(s, s->frame);
+        }
+
+        bool changed = s->drawn != (f != NULL);
+        if (f && s->drawn) {
+            changed = s->pos.x != s->drawn_pos.x ||
+                      s->pos.y != s->drawn_pos.y ||
+                      s->frame != s->drawn_frame || s->z != s->drawn_z;
+        }
+        if (!changed) {
+            continue;
+        }
+
+        if (s->drawn) {
+            damage(layer, s->drawn_pos, get_frame(s, s->drawn_frame));
+        }
+        if (f) {
+            damage(layer, s->pos, f);
+        }
+
+        s->drawn = f != NULL;
+        s->drawn_pos = s->pos;
+        s->drawn_frame = s->frame;
+        s->drawn_z = s->z;
+    }
+}
+
+// Draws opaque pixels of a sprite's row between x1 and x2 into the row
+// being composited
+AESPL_GFX_PX_INLINE void draw_row(aespl_gfx_c_mode_t c_mode,
+                                  aespl_gfx_buf_t *row,
+                                  const aespl_gfx_sprite_t *s, int32_t y,
+                                  int32_t x1, int32_t x2) {
+    const aespl_gfx_sprite_frame_t *f = get_frame(s, s->drawn_frame);
+    int32_t sy = y - s->drawn_pos.y;
+
+    x1 = MAX(x1, s->drawn_pos.x);
+    x2 = MIN(x2, s->drawn_pos.x + f->width - 1);
+    if (sy < 0 || sy >= f->height || x1 > x2) {
+        return;
+    }
+
+    aespl_gfx_view_t mask = frame_mask(s, f);
+
+    for (int32_t x = x1; x <= x2; x += 32) {
+        uint32_t bits = aespl_gfx_view_get_word(&mask, x - s->drawn_pos.x, sy);
+        if (x2 - x < 31) {
+            bits &= ~(0xffffffff >> (x2 - x + 1));
+        }
+        if (!bits) {
+            continue;
+        }
+
+        // MONO sprites are their own masks, so words are ORed as they are
+        if (c_mode == AESPL_GFX_C_MODE_MONO) {
+            uint32_t *d = row->content[0];
+            uint16_t k = x / 32;
+            uint8_t shift = x % 32;
+
+            d[row->wpr - 1 - k] |= bits >> shift;
+            if (shift && k + 1 < row->wpr) {
+                d[row->wpr - 2 - k] |= bits << (32 - shift);
+            }
+            continue;
+        }
+
+        // Color pixels are copied one by one, transparent ones are skipped
+        int32_t sx = f->pos.x + x - s->drawn_pos.x;
+        while (bits) {
+            uint8_t b = __builtin_clz(bits);
+            bits &= ~(0x80000000U >> b);
+
+            uint32_t color = aespl_gfx_mode_get_px(c_mode, s->sheet->buf,
+                                                   sx + b, f->pos.y + sy);
+            aespl_gfx_mode_set_px(c_mode, row, x + b, 0, color);
+        }
+    }
+}
+
+aespl_gfx_err_t aespl_gfx_sprite_layer_draw(aespl_gfx_sprite_layer_t *layer,
+                                            aespl_gfx_buf_t *dst) {
+    if (dst->width != layer->width || dst->height != layer->height ||
+        dst->c_mode != layer->c_mode) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    sort_sprites(layer);
+    damage_changes(layer);
+
+    for (uint16_t y = 0; y < layer->height; y++) {
+        aespl_gfx_sprite_span_t *span = &layer->spans[y];
+        if (span->x1 > span->x2) {
+            continue;
+        }
+
+        int16_t x1 = span->x1, x2 = span->x2;
+        uint16_t w = x2 - x1 + 1;
+        aespl_gfx_view_t row = aespl_gfx_make_view(
+            layer->row, (aespl_gfx_point_t){x1, 0}, w, 1);
+
+        if (layer->bg) {
+            aespl_gfx_view_t bg = aespl_gfx_make_view(
+                layer->bg, (aespl_gfx_point_t){x1, y}, w, 1);
+            aespl_gfx_merge_view(&row, &bg, (aespl_gfx_point_t){0, 0});
+        } else {
+            aespl_gfx_fill_span(layer->row, 0, x1, x2, 0);
+        }
+
+        for (aespl_gfx_sprite_t *s = layer->sprites; s; s = s->next) {
+            if (s->drawn) {
+                AESPL_GFX_DISPATCH(layer->c_mode, draw_row, layer->row, s, y,
+                                   x1, x2);
+            }
+        }
+
+        // Composited in a separate row, so the target changes only where
+        // the result differs
+        aespl_gfx_view_t target = aespl_gfx_make_view(
+            dst, (aespl_gfx_point_t){x1, y}, w, 1);
+        aespl_gfx_merge_view(&target, &row, (aespl_gfx_point_t){0, 0});
+
+        *span = (aespl_gfx_sprite_span_t){INT16_MAX, -1};
+    }
+
+    return AESPL_GFX_OK;
+}
@@ -0,0 +1,233 @@
+#include "aespl/gfx_str_cache.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_text.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// An entry occupies a single memory block: the entry itself, the buffer with
+// its pixels and the string
+struct aespl_gfx_str_cache_entry {
+    aespl_gfx_str_cache_entry_t *prev;  // more recently used entry
+    aespl_gfx_str_cache_entry_t *next;  // less recently used entry
+    const aespl_gfx_font_t *font;
+    aespl_gfx_c_mode_t c_mode;
+    uint32_t color;
+    uint8_t space;
+    uint32_t hash;  // hash of the string
+    char *str;
+    size_t size;    // size of the memory block
+    uint16_t refs;  // number of users
+    bool cached;    // whether the entry is in the list
+};
+
+// Size of an entry, rounded up to keep the buffer's header aligned
+#define ENTRY_SIZE ((sizeof(aespl_gfx_str_cache_entry_t) + 7) & ~(size_t)7)
+
+static inline aespl_gfx_buf_t *entry_buf(aespl_gfx_str_cache_entry_t *e) {
+    return (aespl_gfx_buf_t *)((uint8_t *)e + ENTRY_SIZE);
+}
+
+static inline aespl_gfx_str_cache_entry_t *buf_entry(const aespl_gfx_buf_t *b) {
+    return (aespl_gfx_str_cache_entry_t *)((uint8_t *)b - ENTRY_SIZE);
+}
+
+// FNV-1a
+static uint32_t str_hash(const char *str) {
+    uint32_t h = 2166136261U;
+    while (*str) {
+        h = (h ^ (uint8_t)*str++) * 16777619U;
+    }
+    return h;
+}
+
+static void unlink_entry(aespl_gfx_str_cache_t *cache,
+                         aespl_gfx_str_cache_entry_t *e) {
+    if (e->prev) {
+        e->prev->next = e->next;
+    } else {
+        cache->head = e->next;
+    }
+
+    if (e->next) {
+        e->next->prev = e->prev;
+    } else {
+        cache->tail = e->prev;
+    }
+
+    e->prev = e->next = NULL;
+}
+
+static void push_entry(aespl_gfx_str_cache_t *cache,
+                       aespl_gfx_str_cache_entry_t *e) {
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) {
+        cache->head->prev = e;
+    } else {
+        cache->tail = e;
+    }
+    cache->head = e;
+}
+
+// Drops least recently used entries which are not being used until the cache
+// fits into `limit` bytes
+static void evict(aespl_gfx_str_cache_t *cache, size_t limit) {
+    aespl_gfx_str_cache_entry_t *e = cache->tail;
+
+    while (e && cache->used > limit) {
+        aespl_gfx_str_cache_entry_t *prev = e->prev;
+        if (!e->refs) {
+            unlink_entry(cache, e);
+            cache->used -= e->size;
+            cache->n_evictions++;
+            free(e);
+        }
+        e = prev;
+    }
+}
+
+// Renders a string into a new entry
+static aespl_gfx_str_cache_entry_t *make_entry(aespl_gfx_str_cache_t *cache,
+                                               aespl_gfx_c_mode_t c_mode,
+                                               const aespl_gfx_font_t *font,
+                                               const char *str, uint32_t hash,
+                                               uint32_t color, uint8_t space) {
+    int16_t str_w = aespl_gfx_str_width(font, str, space);
+    if (str_w < 0) {
+        return NULL;
+    }
+
+    size_t buf_size = aespl_gfx_buf_size(str_w, font->height, c_mode);
+    size_t size = ENTRY_SIZE + buf_size + strlen(str) + 1;
+
+    // Make room before allocating, the memory is likely to be reused
+    bool cached = size <= cache->budget;
+    if (cached) {
+        evict(cache, cache->budget - size);
+    }
+
+    aespl_gfx_str_cache_entry_t *e = malloc(size);
+    if (!e) {
+        return NULL;
+    }
+
+    aespl_gfx_buf_t *buf = aespl_gfx_init_buf(entry_buf(e), str_w,
+                                              font->height, c_mode);
+    if (!buf) {
+        free(e);
+        return NULL;
+    }
+    aespl_gfx_puts(buf, font, (aespl_gfx_point_t){0, 0}, str, color, space);
+
+    e->font = font;
+    e->c_mode = c_mode;
+    e->color = color;
+    e->space = space;
+    e->hash = hash;
+    e->str = (char *)buf + buf_size;
+    strcpy(e->str, str);
+    e->size = size;
+    e->refs = 1;
+    e->cached = cached;
+    e->prev = e->next = NULL;
+
+    if (cached) {
+        push_entry(cache, e);
+        cache->used += size;
+    }
+
+    return e;
+}
+
+aespl_gfx_err_t aespl_gfx_str_cache_init(aespl_gfx_str_cache_t *cache,
+                                         size_t budget) {
+    memset(cache, 0, sizeof(*cache));
+    cache->budget = budget;
+
+    cache->lock = xSemaphoreCreateMutex();
+    if (!cache->lock) {
+        return AESPL_GFX_NO_MEM;
+    }
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_str_cache_deinit(aespl_gfx_str_cache_t *cache) {
+    aespl_gfx_str_cache_clear(cache);
+
+    if (cache->lock) {
+        vSemaphoreDelete(cache->lock);
+        cache->lock = NULL;
+    }
+}
+
+const aespl_gfx_buf_t *aespl_gfx_str_cache_get(aespl_gfx_str_cache_t *cache,
+                                               aespl_gfx_c_mode_t c_mode,
+                                               const aespl_gfx_font_t *font,
+                                               const char *str,
+                                               uint32_t color, uint8_t space) {
+    uint32_t hash = str_hash(str);
+    aespl_gfx_str_cache_entry_t *e;
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    for (e = cache->head; e; e = e->next) {
+        if (e->hash == hash && e->font == font && e->c_mode == c_mode &&
+            e->color == color && e->space == space && !strcmp(e->str, str)) {
+            break;
+        }
+    }
+
+    if (e) {
+        cache->n_hits++;
+        e->refs++;
+        unlink_entry(cache, e);
+        push_entry(cache, e);
+    } else {
+        // Render while holding the lock, so a string is never rendered twice
+        cache->n_misses++;
+        e = make_entry(cache, c_mode, font, str, hash, color, space);
+    }
+
+    xSemaphoreGive(cache->lock);
+
+    return e ? entry_buf(e) : NULL;
+}
+
+void aespl_gfx_str_cache_release(aespl_gfx_str_cache_t *cache,
+                                 const aespl_gfx_buf_t *buf) {
+    if (!buf) {
+        return;
+    }
+
+    aespl_gfx_str_cache_entry_t *e = buf_entry(buf);
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    if (e->refs) {
+        e->refs--;
+    }
+
+    if (!e->cached) {
+        if (!e->refs) {
+            free(e);
+        }
+    } else if (cache->used > cache->budget) {
+        // The cache has grown while its buffers were being used
+        evict(cache, cache->budget);
+    }
+
+    xSemaphoreGive(cache->lock);
+}
+
+void aespl_gfx_str_cache_clear(aespl_gfx_str_cache_t *cache) {
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+    evict(cache, 0);
+    xSemaphoreGive(cache->lock);
+}
@@ -0,0 +1,159 @@
+#include "aespl/gfx_swapchain.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aespl/gfx_buffer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifndef CONFIG_AESPL_GFX_FLUSH_STACK_SIZE
+#define CONFIG_AESPL_GFX_FLUSH_STACK_SIZE 2048
+#endif
+
+#ifndef CONFIG_AESPL_GFX_FLUSH_TASK_PRIORITY
+#define CONFIG_AESPL_GFX_FLUSH_TASK_PRIORITY 1
+#endif
+
+#ifndef CONFIG_AESPL_GFX_FLUSH_CORE
+#define CONFIG_AESPL_GFX_FLUSH_CORE 1
+#endif
+
+static void mark_all_dirty(aespl_gfx_buf_t *buf) {
+    aespl_gfx_point_t p2 = {buf->width - 1, buf->height - 1};
+    aespl_gfx_mark_dirty(buf, (aespl_gfx_point_t){0, 0}, p2);
+}
+
+static void flush_task(void *args) {
+    aespl_gfx_swapchain_t *sc = (aespl_gfx_swapchain_t *)args;
+    aespl_gfx_buf_t *buf;
+
+    // NULL asks the task to stop
+    while (xQueueReceive(sc->present_q, &buf, portMAX_DELAY) == pdTRUE && buf) {
+        sc->flush(sc->flush_args, buf);
+        xQueueSend(sc->free_q, &buf, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(sc->done);
+    vTaskDelete(NULL);
+}
+
+// Frees everything but the flush task
+static void free_resources(aespl_gfx_swapchain_t *sc) {
+    if (sc->free_q) {
+        vQueueDelete(sc->free_q);
+        sc->free_q = NULL;
+    }
+
+    if (sc->present_q) {
+        vQueueDelete(sc->present_q);
+        sc->present_q = NULL;
+    }
+
+    if (sc->done) {
+        vSemaphoreDelete(sc->done);
+        sc->done = NULL;
+    }
+
+    if (sc->bufs) {
+        aespl_gfx_free_buf_array(sc->bufs);
+        sc->bufs = NULL;
+    }
+}
+
+aespl_gfx_err_t aespl_gfx_swapchain_init(aespl_gfx_swapchain_t *sc,
+                                         uint8_t length, uint16_t width,
+                                         uint16_t height,
+                                         aespl_gfx_c_mode_t c_mode,
+                                         bool preserve, aespl_gfx_flush_t flush,
+                                         void *flush_args) {
+    if (length < 2 || !flush) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    memset(sc, 0, sizeof(*sc));
+    sc->preserve = preserve;
+    sc->flush = flush;
+    sc->flush_args = flush_args;
+
+    // Queues hold pointers to buffers, the present one also a stop request
+    sc->bufs = aespl_gfx_make_buf_array(length, width, height, c_mode);
+    sc->free_q = xQueueCreate(length, sizeof(aespl_gfx_buf_t *));
+    sc->present_q = xQueueCreate(length + 1, sizeof(aespl_gfx_buf_t *));
+    sc->done = xSemaphoreCreateBinary();
+    if (!sc->bufs || !sc->free_q || !sc->present_q || !sc->done) {
+        free_resources(sc);
+        return AESPL_GFX_NO_MEM;
+    }
+
+    // The display's content is unknown, so the first frames are sent whole
+    for (uint8_t i = 0; i < length; i++) {
+        aespl_gfx_buf_t *buf = sc->bufs->buffers[i];
+        if (aespl_gfx_track_dirty(buf, true) != AESPL_GFX_OK) {
+            free_resources(sc);
+            return AESPL_GFX_NO_MEM;
+        }
+        mark_all_dirty(buf);
+        xQueueSend(sc->free_q, &buf, 0);
+    }
+
+#if portNUM_PROCESSORS > 1
+    BaseType_t res = xTaskCreatePinnedToCore(
+        flush_task, "gfx_flush", CONFIG_AESPL_GFX_FLUSH_STACK_SIZE, sc,
+        CONFIG_AESPL_GFX_FLUSH_TASK_PRIORITY, NULL,
+        CONFIG_AESPL_GFX_FLUSH_CORE);
+#else
+    BaseType_t res = xTaskCreate(flush_task, "gfx_flush",
+                                 CONFIG_AESPL_GFX_FLUSH_STACK_SIZE, sc,
+                                 CONFIG_AESPL_GFX_FLUSH_TASK_PRIORITY, NULL);
+#endif
+    if (res != pdPASS) {
+        free_resources(sc);
+        return AESPL_GFX_NO_MEM;
+    }
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_swapchain_deinit(aespl_gfx_swapchain_t *sc) {
+    aespl_gfx_buf_t *stop = NULL;
+
+    xQueueSend(sc->present_q, &stop, portMAX_DELAY);
+    xSemaphoreTake(sc->done, portMAX_DELAY);
+
+    free_resources(sc);
+}
+
+aespl_gfx_buf_t *aespl_gfx_swapchain_acquire(aespl_gfx_swapchain_t *sc,
+                                             TickType_t timeout) {
+    aespl_gfx_buf_t *buf;
+
+    if (xQueueReceive(sc->free_q, &buf, timeout) != pdTRUE) {
+        return NULL;
+    }
+
+    if (!sc->preserve) {
+        mark_all_dirty(buf);
+    } else if (sc->last && sc->last != buf) {
+        // The flush task only reads the last buffer's pixels
+        aespl_gfx_point_t zero = {0, 0};
+        aespl_gfx_merge(buf, sc->last, zero, zero);
+    }
+
+    return buf;
+}
+
+aespl_gfx_err_t aespl_gfx_swapchain_present(aespl_gfx_swapchain_t *sc,
+                                            aespl_gfx_buf_t *buf) {
+    if (xQueueSend(sc->present_q, &buf, portMAX_DELAY) != pdTRUE) {
+        return AESPL_GFX_FAIL;
+    }
+
+    sc->last = buf;
+
+    return AESPL_GFX_OK;
+}
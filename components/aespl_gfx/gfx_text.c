@@ -1,58 +1,301 @@
 #include "aespl/gfx_text.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "aespl/gfx_geometry.h"
 
-int8_t aespl_gfx_putc(aespl_gfx_buf_t *buf, const aespl_gfx_font_t *font,
-                      aespl_gfx_point_t pos, uint8_t ch, uint32_t color) {
-    int8_t ch_width = 0;
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+// A glyph found in a font
+typedef struct {
+    const aespl_gfx_font_t *font;
+    uint32_t offset;  // offset of the glyph's first row in the font
+    int8_t width;     // width of the character
+    uint8_t cols;     // number of columns stored in a row
+    uint8_t height;   // number of rows
+    uint8_t top;      // number of empty rows above the glyph
+    uint8_t row;      // number of the next row to read
+    uint32_t nibble;  // RLE: position of the next nibble in the bitmap
+    uint32_t run;     // RLE: pixels left in the current run
+    bool on;          // RLE: whether the current run is set pixels
+} glyph_t;
+
+// Looks up a glyph of a sparse font by binary search
+static const aespl_gfx_glyph_t *find_sparse_glyph(const aespl_gfx_font_t *font,
+                                                  uint32_t code) {
+    uint16_t lo = 0, hi = font->n_glyphs;
+
+    while (lo < hi) {
+        uint16_t mid = lo + (hi - lo) / 2;
+        uint32_t mid_code = font->glyphs[mid].code;
+        if (mid_code == code) {
+            return &font->glyphs[mid];
+        }
+        if (mid_code < code) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return NULL;
+}
+
+static aespl_gfx_err_t find_glyph(const aespl_gfx_font_t *font, uint32_t ch,
+                                  glyph_t *glyph) {
+    glyph->font = font;
+    glyph->row = 0;
+
+    if (font->glyphs) {
+        const aespl_gfx_glyph_t *g = find_sparse_glyph(font, ch);
+        if (!g) {
+            return AESPL_GFX_BAD_CHAR;
+        }
+
+        glyph->offset = g->offset;
+        glyph->width = g->width;
+        glyph->cols = MIN(g->width, 32);
+        glyph->height = g->height;
+        glyph->top = g->top;
+
+        // The first run is read with the first row
+        glyph->nibble = g->offset * 2;
+        glyph->run = 0;
+        glyph->on = true;
+
+        return AESPL_GFX_OK;
+    }
 
     // Check if the character is covered by the font
-    if (ch - font->ascii_offset + 1 > font->length) {
+    if (ch < font->ascii_offset || ch - font->ascii_offset + 1 > font->length) {
         return AESPL_GFX_BAD_CHAR;
     }
+    if (font->width != AESPL_GFX_FONT_WIDTH_8 &&
+        font->width != AESPL_GFX_FONT_WIDTH_16) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    // First byte/word of a character is its actual width
+    uint32_t offset = (ch - font->ascii_offset) * (font->height + 1);
+    glyph->offset = offset + 1;
+    glyph->width = font->width == AESPL_GFX_FONT_WIDTH_8
+                       ? (int8_t)font->content.c8[offset]
+                       : (int8_t)font->content.c16[offset];
+    glyph->cols = MIN((int32_t)glyph->width, (int32_t)font->width);
+    glyph->height = font->height;
+    glyph->top = 0;
+
+    return AESPL_GFX_OK;
+}
+
+// Makes a mask of bits `31 - first` down to `32 - end`
+static inline uint32_t span_mask(uint8_t first, uint8_t end) {
+    return (0xffffffff >> first) & ~(end < 32 ? 0xffffffff >> end : 0);
+}
 
-    // Offset from the beginning of the font content
-    uint16_t offset = (ch - font->ascii_offset) * (font->height + 1);
-
-    // Locate character's position and determine its actual width from first
-    // byte/word
-    void *ch_p = NULL;
-    switch (font->width) {
-        case AESPL_GFX_FONT_WIDTH_8:
-            ch_p = (uint8_t *)&font->content.c8[offset];
-            ch_width = *(int8_t *)ch_p++;
-            break;
-        case AESPL_GFX_FONT_WIDTH_16:
-            ch_p = (uint16_t *)&font->content.c16[offset];
-            ch_width = *(int16_t *)ch_p++;
-            break;
-    }
-
-    // Each row
-    for (uint8_t row_n = 0; row_n < font->height; row_n++) {
-        uint64_t row;
-
-        switch (font->width) {
-            case AESPL_GFX_FONT_WIDTH_8:
-                row = *(uint8_t *)ch_p++;
-                break;
-            case AESPL_GFX_FONT_WIDTH_16:
-                row = *(uint16_t *)ch_p++;
-                break;
-            default:
-                return AESPL_GFX_BAD_ARG;
+// Reads a run length of an RLE glyph
+static uint32_t rle_read_run(glyph_t *glyph) {
+    const uint8_t *bitmap = glyph->font->bitmap;
+    uint32_t len = 0;
+    uint8_t n;
+
+    do {
+        uint8_t byte = bitmap[glyph->nibble / 2];
+        n = glyph->nibble++ % 2 ? byte & 0xf : byte >> 4;
+        len += n;
+    } while (n == 15);
+
+    return len;
+}
+
+// Decodes the next row of an RLE glyph straight from the font, no buffer is
+// needed as runs are consumed row by row
+static uint32_t rle_next_row(glyph_t *glyph) {
+    uint32_t bits = 0;
+    uint8_t col = 0;
+
+    while (col < glyph->cols) {
+        while (!glyph->run) {
+            glyph->on = !glyph->on;
+            glyph->run = rle_read_run(glyph);
         }
 
-        // Each column
-        for (int8_t n = 0, col_n = font->width - 1; n < ch_width;
-             n++, col_n--) {
-            if (1 & (row >> col_n)) {  // if pixel is set
-                aespl_gfx_set_px(buf, pos.x + n, pos.y + row_n, color);
-            }
+        uint8_t n = MIN(glyph->run, (uint32_t)(glyph->cols - col));
+        if (glyph->on) {
+            bits |= span_mask(col, col + n);
         }
+        col += n;
+        glyph->run -= n;
     }
 
-    return ch_width;
+    return bits;
+}
+
+// Gets the next row of a glyph aligned to the most significant bit of a word,
+// so that the glyph's column `n` is in bit `31 - n`
+static inline uint32_t glyph_next_row(glyph_t *glyph) {
+    const aespl_gfx_font_t *font = glyph->font;
+    uint8_t row_n = glyph->row++;
+
+    if (font->glyphs) {
+        if (font->enc == AESPL_GFX_FONT_ENC_RLE) {
+            return rle_next_row(glyph);
+        }
+
+        uint8_t bpr = (glyph->cols + 7) / 8;
+        const uint8_t *p = font->bitmap + glyph->offset + row_n * bpr;
+        uint32_t bits = 0;
+        for (uint8_t i = 0; i < bpr; i++) {
+            bits |= (uint32_t)p[i] << (24 - 8 * i);
+        }
+        return bits;
+    }
+
+    if (font->width == AESPL_GFX_FONT_WIDTH_8) {
+        return (uint32_t)font->content.c8[glyph->offset + row_n] << 24;
+    }
+
+    return (uint32_t)font->content.c16[glyph->offset + row_n] << 16;
+}
+
+// Skips rows of a glyph, RLE ones have to be decoded
+static inline void glyph_skip_rows(glyph_t *glyph, uint8_t n) {
+    if (glyph->font->glyphs && glyph->font->enc == AESPL_GFX_FONT_ENC_RLE) {
+        while (n--) {
+            rle_next_row(glyph);
+            glyph->row++;
+        }
+    } else {
+        glyph->row += n;
+    }
+}
+
+// Decodes a UTF-8 character and advances the string. Malformed sequences are
+// skipped byte by byte, each decoded as U+FFFD.
+static uint32_t utf8_next(const char **s) {
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t c = *p++;
+    uint8_t n;
+
+    if (c < 0x80) {
+        *s = (const char *)p;
+        return c;
+    } else if (c >= 0xc0 && c < 0xe0) {
+        n = 1;
+        c &= 0x1f;
+    } else if (c >= 0xe0 && c < 0xf0) {
+        n = 2;
+        c &= 0x0f;
+    } else if (c >= 0xf0 && c < 0xf8) {
+        n = 3;
+        c &= 0x07;
+    } else {
+        *s += 1;
+        return 0xfffd;
+    }
+
+    for (uint8_t i = 0; i < n; i++, p++) {
+        if ((*p & 0xc0) != 0x80) {
+            *s += 1;
+            return 0xfffd;
+        }
+        c = c << 6 | (*p & 0x3f);
+    }
+
+    *s = (const char *)p;
+
+    return c;
+}
+
+// ORs or clears bits of a glyph's row at position `x` of a MONO row. Bits
+// outside of the buffer must be masked out by the caller.
+static inline bool mono_put_row(uint32_t *row, uint16_t wpr, int32_t x,
+                                uint32_t bits, uint32_t color) {
+    // Columns to the left of the buffer are masked out
+    if (x < 0) {
+        bits <<= -x;
+        x = 0;
+    }
+
+    // The row may straddle a word boundary
+    uint8_t shift = x % 32;
+    uint32_t *w = &row[wpr - 1 - x / 32];
+    uint32_t lo = bits >> shift, hi = shift ? bits << (32 - shift) : 0;
+    uint32_t prev = *w, prev_next = 0;
+
+    *w = color ? prev | lo : prev & ~lo;
+    if (hi) {
+        prev_next = *(w - 1);
+        *(w - 1) = color ? prev_next | hi : prev_next & ~hi;
+        return *w != prev || *(w - 1) != prev_next;
+    }
+
+    return *w != prev;
+}
+
+int8_t aespl_gfx_putc(aespl_gfx_buf_t *buf, const aespl_gfx_font_t *font,
+                      aespl_gfx_point_t pos, uint32_t ch, uint32_t color) {
+    glyph_t glyph;
+    aespl_gfx_err_t err = find_glyph(font, ch, &glyph);
+    if (err) {
+        return err;
+    }
+
+    // Glyphs of sparse fonts may start below the top of the line
+    pos.y += glyph.top;
+
+    // Clip the glyph once, rows and columns are relative to the glyph
+    int32_t r_first = MAX(0, -pos.y);
+    int32_t r_end = MIN((int32_t)glyph.height, buf->height - pos.y);
+    int32_t c_first = MAX(0, -pos.x);
+    int32_t c_end = MIN((int32_t)glyph.cols, buf->width - pos.x);
+    if (r_first >= r_end || c_first >= c_end) {
+        return glyph.width;
+    }
+    uint32_t mask = span_mask(c_first, c_end);
+
+    bool changed = false;
+    glyph_skip_rows(&glyph, r_first);
+    for (int32_t row_n = r_first; row_n < r_end; row_n++) {
+        uint32_t bits = glyph_next_row(&glyph) & mask;
+        if (!bits) {
+            continue;
+        }
+
+        int32_t y = pos.y + row_n;
+
+        // MONO rows get whole glyph rows at once
+        if (buf->c_mode == AESPL_GFX_C_MODE_MONO) {
+            changed |=
+                mono_put_row(buf->content[y], buf->wpr, pos.x, bits, color);
+            continue;
+        }
+
+        // Color rows get a span per run of set bits
+        while (bits) {
+            uint8_t start = __builtin_clz(bits);
+            uint32_t rest = ~(bits << start);
+            uint8_t len = rest ? __builtin_clz(rest) : 32 - start;
+            aespl_gfx_fill_span(buf, y, pos.x + start, pos.x + start + len - 1,
+                                color);
+            bits &= ~span_mask(start, start + len);
+        }
+    }
+
+    if (changed) {
+        aespl_gfx_mark_dirty(
+            buf, (aespl_gfx_point_t){pos.x + c_first, pos.y + r_first},
+            (aespl_gfx_point_t){pos.x + c_end - 1, pos.y + r_end - 1});
+    }
+
+    return glyph.width;
 }
 
 aespl_gfx_point_t aespl_gfx_puts(aespl_gfx_buf_t *buf,
@@ -62,7 +305,8 @@ aespl_gfx_point_t aespl_gfx_puts(aespl_gfx_buf_t *buf,
     int8_t ch_width;
 
     while (*s) {
-        ch_width = aespl_gfx_putc(buf, font, pos, *s++, color);
+        uint32_t ch = aespl_gfx_next_char(font, &s);
+        ch_width = aespl_gfx_putc(buf, font, pos, ch, color);
         if (ch_width < 0) {
             return pos;
         }
@@ -72,34 +316,30 @@ aespl_gfx_point_t aespl_gfx_puts(aespl_gfx_buf_t *buf,
     return pos;
 }
 
-int8_t aespl_gfx_ch_width(const aespl_gfx_font_t *font, char ch) {
-    // Check if the character is covered by the font
-    if (ch - font->ascii_offset + 1 > font->length) {
-        return AESPL_GFX_BAD_CHAR;
+int8_t aespl_gfx_ch_width(const aespl_gfx_font_t *font, uint32_t ch) {
+    glyph_t glyph;
+    aespl_gfx_err_t err = find_glyph(font, ch, &glyph);
+    if (err) {
+        return err;
     }
 
-    // Offset from the beginning of the font content
-    uint16_t offset = (ch - font->ascii_offset) * (font->height + 1);
+    return glyph.width;
+}
 
-    switch (font->width) {
-        case AESPL_GFX_FONT_WIDTH_8:
-            return font->content.c8[offset];
-            break;
-        case AESPL_GFX_FONT_WIDTH_16:
-            return font->content.c16[offset];
-            break;
+uint32_t aespl_gfx_next_char(const aespl_gfx_font_t *font, const char **s) {
+    if (font->glyphs) {
+        return utf8_next(s);
     }
 
-    return AESPL_GFX_FAIL;
+    return (uint8_t)*(*s)++;
 }
 
 int16_t aespl_gfx_str_width(const aespl_gfx_font_t *font, const char *str,
                             uint8_t space) {
     int16_t w = 0, ch_w = 0;
-    char *c = (char *)str;
 
-    while (*c) {
-        ch_w = aespl_gfx_ch_width(font, *c++);
+    while (*str) {
+        ch_w = aespl_gfx_ch_width(font, aespl_gfx_next_char(font, &str));
         if (ch_w < 0) {
             return ch_w;
         }
@@ -109,10 +349,12 @@ int16_t aespl_gfx_str_width(const aespl_gfx_font_t *font, const char *str,
     return w;
 }
 
-aespl_gfx_buf_t *aespl_gfx_make_str_buf(aespl_gfx_c_mode_t c_mode,
-                                        const aespl_gfx_font_t *font,
-                                        const char *str, uint32_t color,
-                                        uint8_t space) {
+// Creates a buffer on the heap or in a pool and puts a string into it
+static aespl_gfx_buf_t *make_str_buf(aespl_gfx_pool_t *pool,
+                                     aespl_gfx_c_mode_t c_mode,
+                                     const aespl_gfx_font_t *font,
+                                     const char *str, uint32_t color,
+                                     uint8_t space) {
     // Calculate buffer's width
     int16_t str_w = aespl_gfx_str_width(font, str, space);
     if (str_w < 0) {
@@ -120,7 +362,12 @@ aespl_gfx_buf_t *aespl_gfx_make_str_buf(aespl_gfx_c_mode_t c_mode,
     }
 
     // Create a buffer
-    aespl_gfx_buf_t *buf = aespl_gfx_make_buf(str_w, font->height, c_mode);
+    aespl_gfx_buf_t *buf;
+    if (pool) {
+        buf = aespl_gfx_pool_make_buf(pool, str_w, font->height, c_mode);
+    } else {
+        buf = aespl_gfx_make_buf(str_w, font->height, c_mode);
+    }
     if (!buf) {
         return NULL;
     }
@@ -130,3 +377,18 @@ aespl_gfx_buf_t *aespl_gfx_make_str_buf(aespl_gfx_c_mode_t c_mode,
 
     return buf;
 }
+
+aespl_gfx_buf_t *aespl_gfx_make_str_buf(aespl_gfx_c_mode_t c_mode,
+                                        const aespl_gfx_font_t *font,
+                                        const char *str, uint32_t color,
+                                        uint8_t space) {
+    return make_str_buf(NULL, c_mode, font, str, color, space);
+}
+
+aespl_gfx_buf_t *aespl_gfx_pool_make_str_buf(aespl_gfx_pool_t *pool,
+                                             aespl_gfx_c_mode_t c_mode,
+                                             const aespl_gfx_font_t *font,
+                                             const char *str, uint32_t color,
+                                             uint8_t space) {
+    return make_str_buf(pool, c_mode, font, str, color, space);
+}
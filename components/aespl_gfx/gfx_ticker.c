@@ -0,0 +1,202 @@
+#include "aespl/gfx_ticker.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_px.h"
+#include "aespl/gfx_text.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Takes the next character out of the queue, the lock must be held
+static bool pop_char(aespl_gfx_ticker_t *ticker, uint32_t *ch) {
+    if (!ticker->text_len) {
+        return false;
+    }
+
+    // Sparse fonts take a whole UTF-8 sequence
+    uint8_t lead = ticker->text[ticker->text_head], n = 1;
+    if (ticker->font->glyphs) {
+        n = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 1;
+    }
+    if (n > ticker->text_len) {
+        n = ticker->text_len;
+    }
+
+    char s[5] = {0};
+    for (uint8_t i = 0; i < n; i++) {
+        s[i] = ticker->text[(ticker->text_head + i) % ticker->text_size];
+    }
+
+    // A malformed sequence is consumed byte by byte
+    const char *p = s;
+    *ch = aespl_gfx_next_char(ticker->font, &p);
+    ticker->text_head = (ticker->text_head + (p - s)) % ticker->text_size;
+    ticker->text_len -= p - s;
+
+    return true;
+}
+
+// Renders the next queued character, characters missing in the font are
+// skipped. The lock must be held, so that the queue and columns of the
+// current character change together.
+static void load_char(aespl_gfx_ticker_t *ticker) {
+    uint32_t ch;
+
+    ticker->col = 0;
+    ticker->cols = 0;
+
+    while (pop_char(ticker, &ch)) {
+        aespl_gfx_clear_buf(ticker->glyph);
+        int8_t width = aespl_gfx_putc(ticker->glyph, ticker->font,
+                                      (aespl_gfx_point_t){0, 0}, ch, 1);
+        if (width >= 0) {
+            ticker->ch_width = width;
+            ticker->cols = width + ticker->space;
+            return;
+        }
+    }
+}
+
+aespl_gfx_err_t aespl_gfx_ticker_init(aespl_gfx_ticker_t *ticker,
+                                      uint16_t width, aespl_gfx_c_mode_t c_mode,
+                                      const aespl_gfx_font_t *font,
+                                      uint32_t color, uint8_t space,
+                                      size_t text_size) {
+    if (!width || !text_size) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    memset(ticker, 0, sizeof(*ticker));
+    ticker->font = font;
+    ticker->color = color;
+    ticker->space = space;
+    ticker->text_size = text_size;
+
+    ticker->buf = aespl_gfx_make_buf(width, font->height, c_mode);
+    ticker->glyph = aespl_gfx_make_buf(32, font->height, AESPL_GFX_C_MODE_MONO);
+    ticker->text = malloc(text_size);
+    ticker->lock = xSemaphoreCreateMutex();
+
+    if (!ticker->buf || !ticker->glyph || !ticker->text || !ticker->lock) {
+        aespl_gfx_ticker_deinit(ticker);
+        return AESPL_GFX_NO_MEM;
+    }
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_ticker_deinit(aespl_gfx_ticker_t *ticker) {
+    if (ticker->buf) {
+        aespl_gfx_free_buf(ticker->buf);
+        ticker->buf = NULL;
+    }
+
+    if (ticker->glyph) {
+        aespl_gfx_free_buf(ticker->glyph);
+        ticker->glyph = NULL;
+    }
+
+    if (ticker->lock) {
+        vSemaphoreDelete(ticker->lock);
+        ticker->lock = NULL;
+    }
+
+    free(ticker->text);
+    ticker->text = NULL;
+}
+
+aespl_gfx_err_t aespl_gfx_ticker_append(aespl_gfx_ticker_t *ticker,
+                                        const char *str) {
+    size_t len = strlen(str);
+    aespl_gfx_err_t err = AESPL_GFX_OK;
+
+    xSemaphoreTake(ticker->lock, portMAX_DELAY);
+
+    if (len > ticker->text_size - ticker->text_len) {
+        err = AESPL_GFX_NO_MEM;
+    } else {
+        size_t tail = ticker->text_head + ticker->text_len;
+        for (size_t i = 0; i < len; i++) {
+            ticker->text[(tail + i) % ticker->text_size] = str[i];
+        }
+        ticker->text_len += len;
+    }
+
+    xSemaphoreGive(ticker->lock);
+
+    return err;
+}
+
+void aespl_gfx_ticker_step(aespl_gfx_ticker_t *ticker) {
+    aespl_gfx_buf_t *buf = ticker->buf;
+
+    // Word-wise shift of the whole buffer
+    aespl_gfx_move(buf, (aespl_gfx_point_t){-1, 0});
+
+    xSemaphoreTake(ticker->lock, portMAX_DELAY);
+
+    if (ticker->col >= ticker->cols) {
+        load_char(ticker);
+    }
+
+    // Only the exposed column is drawn
+    if (ticker->col < ticker->ch_width && ticker->col < ticker->cols) {
+        for (uint16_t y = 0; y < buf->height; y++) {
+            if (aespl_gfx_mono_get_px(ticker->glyph, ticker->col, y)) {
+                aespl_gfx_set_px(buf, buf->width - 1, y, ticker->color);
+            }
+        }
+    }
+
+    if (ticker->col < ticker->cols) {
+        ticker->col++;
+    }
+
+    xSemaphoreGive(ticker->lock);
+}
+
+bool aespl_gfx_ticker_is_empty(aespl_gfx_ticker_t *ticker) {
+    xSemaphoreTake(ticker->lock, portMAX_DELAY);
+    bool empty = !ticker->text_len && ticker->col >= ticker->cols;
+    xSemaphoreGive(ticker->lock);
+
+    return empty;
+}
+
+static aespl_gfx_anim_state_t animate(void *args, uint32_t frame_n) {
+    aespl_gfx_ticker_t *ticker = (aespl_gfx_ticker_t *)args;
+
+    aespl_gfx_ticker_step(ticker);
+    if (ticker->cb) {
+        ticker->cb(ticker->cb_args, ticker->buf);
+    }
+
+    return AESPL_GFX_ANIM_CONTINUE;
+}
+
+aespl_gfx_err_t aespl_gfx_ticker_start(aespl_gfx_ticker_t *ticker, uint8_t fps,
+                                       aespl_gfx_ticker_cb_t cb,
+                                       void *cb_args) {
+    if (aespl_gfx_anim_is_active(ticker->anim) || !fps) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    ticker->cb = cb;
+    ticker->cb_args = cb_args;
+
+    ticker->anim = aespl_gfx_animate(animate, ticker, fps);
+    if (ticker->anim == AESPL_GFX_ANIM_NONE) {
+        return AESPL_GFX_NO_MEM;
+    }
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_ticker_stop(aespl_gfx_ticker_t *ticker) {
+    aespl_gfx_anim_join(ticker->anim);
+    ticker->anim = AESPL_GFX_ANIM_NONE;
+}
@@ -0,0 +1,309 @@
+#include "aespl/gfx_transform.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_px.h"
+
+// Table of reversed bytes
+#define R2(n) n, n + 2 * 64, n + 1 * 64, n + 3 * 64
+#define R4(n) R2(n), R2(n + 2 * 16), R2(n + 1 * 16), R2(n + 3 * 16)
+#define R6(n) R4(n), R4(n + 2 * 4), R4(n + 1 * 4), R4(n + 3 * 4)
+static const uint8_t rev8[256] = {R6(0), R6(2), R6(1), R6(3)};
+
+static inline uint32_t rev32(uint32_t w) {
+    return (uint32_t)rev8[w & 0xff] << 24 |
+           (uint32_t)rev8[(w >> 8) & 0xff] << 16 |
+           (uint32_t)rev8[(w >> 16) & 0xff] << 8 | rev8[w >> 24];
+}
+
+// Transposes a matrix of 8x8 bits, the leftmost column in the most
+// significant bits. See "Hacker's Delight", 7-3.
+static void transpose8(uint8_t m[8]) {
+    uint32_t x = (uint32_t)m[0] << 24 | m[1] << 16 | m[2] << 8 | m[3];
+    uint32_t y = (uint32_t)m[4] << 24 | m[5] << 16 | m[6] << 8 | m[7];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00aa00aa;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00aa00aa;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000cccc;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000cccc;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xf0f0f0f0) | ((y >> 4) & 0x0f0f0f0f);
+    y = ((x << 4) & 0xf0f0f0f0) | (y & 0x0f0f0f0f);
+    x = t;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        m[i] = x >> (24 - 8 * i);
+        m[i + 4] = y >> (24 - 8 * i);
+    }
+}
+
+static void reverse_tile_rows(uint8_t tile[8]) {
+    for (uint8_t i = 0; i < 4; i++) {
+        uint8_t tmp = tile[i];
+        tile[i] = tile[7 - i];
+        tile[7 - i] = tmp;
+    }
+}
+
+// Gets a block of 8x8 MONO pixels, `x` must be a multiple of 8. Rows outside
+// of the buffer are zeros.
+static void get_tile(const aespl_gfx_buf_t *buf, int32_t x, int32_t y,
+                     uint8_t tile[8]) {
+    for (uint8_t i = 0; i < 8; i++) {
+        tile[i] = 0;
+        if (y + i < buf->height) {
+            uint32_t w = buf->content[y + i][buf->wpr - 1 - x / 32];
+            tile[i] = w >> (24 - x % 32);
+        }
+    }
+}
+
+// Puts a block of 8x8 MONO pixels, `x` must be a multiple of 8. Rows outside
+// of the buffer are skipped.
+static void put_tile(aespl_gfx_buf_t *buf, int32_t x, int32_t y,
+                     const uint8_t tile[8]) {
+    uint8_t shift = 24 - x % 32;
+    for (uint8_t i = 0; i < 8 && y + i < buf->height; i++) {
+        uint32_t *w = &buf->content[y + i][buf->wpr - 1 - x / 32];
+        *w = (*w & ~(0xffU << shift)) | (uint32_t)tile[i] << shift;
+    }
+}
+
+static void mark_all_dirty(aespl_gfx_buf_t *buf) {
+    aespl_gfx_point_t p2 = {buf->width - 1, buf->height - 1};
+    aespl_gfx_mark_dirty(buf, (aespl_gfx_point_t){0, 0}, p2);
+}
+
+void aespl_gfx_rotate_tile(uint8_t tile[8], aespl_gfx_rotation_t rot) {
+    switch (rot) {
+        case AESPL_GFX_ROTATE_0:
+            break;
+
+        case AESPL_GFX_ROTATE_90:
+            // Transposition followed by horizontal mirroring
+            transpose8(tile);
+            for (uint8_t i = 0; i < 8; i++) {
+                tile[i] = rev8[tile[i]];
+            }
+            break;
+
+        case AESPL_GFX_ROTATE_180:
+            reverse_tile_rows(tile);
+            for (uint8_t i = 0; i < 8; i++) {
+                tile[i] = rev8[tile[i]];
+            }
+            break;
+
+        case AESPL_GFX_ROTATE_270:
+            // Transposition followed by vertical mirroring
+            transpose8(tile);
+            reverse_tile_rows(tile);
+            break;
+    }
+}
+
+// Mirrors a MONO row. A row is a big number, leftmost pixel being the most
+// significant bit, so all its bits are reversed and then the padding, which
+// has moved to the left, is shifted out.
+static void mono_flip_row(uint32_t *row, uint16_t wpr, uint16_t width) {
+    for (uint16_t i = 0; i < wpr / 2; i++) {
+        uint32_t tmp = rev32(row[i]);
+        row[i] = rev32(row[wpr - 1 - i]);
+        row[wpr - 1 - i] = tmp;
+    }
+    if (wpr % 2) {
+        row[wpr / 2] = rev32(row[wpr / 2]);
+    }
+
+    uint8_t pad = wpr * 32 - width;
+    if (!pad) {
+        return;
+    }
+
+    // Words are stored in reverse order, the leftmost one is the last
+    for (uint16_t k = wpr; k > 0; k--) {
+        uint32_t next = k > 1 ? row[k - 2] : 0;
+        row[k - 1] = row[k - 1] << pad | next >> (32 - pad);
+    }
+}
+
+void aespl_gfx_flip_h(aespl_gfx_buf_t *buf) {
+    for (uint16_t y = 0; y < buf->height; y++) {
+        uint32_t *row = buf->content[y];
+
+        switch (buf->c_mode) {
+            case AESPL_GFX_C_MODE_MONO:
+                mono_flip_row(row, buf->wpr, buf->width);
+                break;
+
+            case AESPL_GFX_C_MODE_RGB565: {
+                uint16_t *px = (uint16_t *)row;
+                for (uint16_t i = 0, j = buf->width - 1; i < j; i++, j--) {
+                    uint16_t tmp = px[i];
+                    px[i] = px[j];
+                    px[j] = tmp;
+                }
+                break;
+            }
+
+            case AESPL_GFX_C_MODE_ARGB888:
+                for (uint16_t i = 0, j = buf->width - 1; i < j; i++, j--) {
+                    uint32_t tmp = row[i];
+                    row[i] = row[j];
+                    row[j] = tmp;
+                }
+                break;
+        }
+    }
+
+    mark_all_dirty(buf);
+}
+
+void aespl_gfx_flip_v(aespl_gfx_buf_t *buf) {
+    for (uint16_t i = 0, j = buf->height - 1; i < j; i++, j--) {
+        // Separately allocated rows may just swap places
+        if (buf->storage == AESPL_GFX_BUF_STORAGE_ROWS) {
+            uint32_t *tmp = buf->content[i];
+            buf->content[i] = buf->content[j];
+            buf->content[j] = tmp;
+            continue;
+        }
+
+        for (uint16_t k = 0; k < buf->wpr; k++) {
+            uint32_t tmp = buf->content[i][k];
+            buf->content[i][k] = buf->content[j][k];
+            buf->content[j][k] = tmp;
+        }
+    }
+
+    mark_all_dirty(buf);
+}
+
+// Transposes a MONO buffer by 8x8 blocks. In place, blocks on both sides of
+// the diagonal are read before being written.
+static void mono_transpose(aespl_gfx_buf_t *dst, const aespl_gfx_buf_t *src) {
+    bool in_place = dst == src;
+    uint8_t a[8], b[8];
+
+    for (int32_t y = 0; y < src->height; y += 8) {
+        for (int32_t x = in_place ? y : 0; x < src->width; x += 8) {
+            get_tile(src, x, y, a);
+            if (in_place && x != y) {
+                get_tile(src, y, x, b);
+                transpose8(b);
+                put_tile(dst, x, y, b);
+            }
+            transpose8(a);
+            put_tile(dst, y, x, a);
+        }
+    }
+}
+
+// Transposes a buffer pixel by pixel, in place pixels are swapped
+AESPL_GFX_PX_INLINE void px_transpose(aespl_gfx_c_mode_t c_mode,
+                                      aespl_gfx_buf_t *dst,
+                                      const aespl_gfx_buf_t *src) {
+    bool in_place = dst == src;
+
+    for (uint16_t y = 0; y < src->height; y++) {
+        for (uint16_t x = in_place ? y + 1 : 0; x < src->width; x++) {
+            uint32_t c = aespl_gfx_mode_get_px(c_mode, src, x, y);
+            if (in_place) {
+                uint32_t c2 = aespl_gfx_mode_get_px(c_mode, src, y, x);
+                aespl_gfx_mode_set_px(c_mode, dst, x, y, c2);
+            }
+            aespl_gfx_mode_set_px(c_mode, dst, y, x, c);
+        }
+    }
+}
+
+aespl_gfx_err_t aespl_gfx_transpose(aespl_gfx_buf_t *dst,
+                                    const aespl_gfx_buf_t *src) {
+    if (dst->c_mode != src->c_mode || dst->width != src->height ||
+        dst->height != src->width) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    if (dst->c_mode == AESPL_GFX_C_MODE_MONO) {
+        mono_transpose(dst, src);
+    } else {
+        AESPL_GFX_DISPATCH(dst->c_mode, px_transpose, dst, src);
+    }
+
+    mark_all_dirty(dst);
+
+    return AESPL_GFX_OK;
+}
+
+aespl_gfx_err_t aespl_gfx_rotate(aespl_gfx_buf_t *dst,
+                                 const aespl_gfx_buf_t *src,
+                                 aespl_gfx_rotation_t rot) {
+    aespl_gfx_point_t zero = {0, 0};
+    aespl_gfx_err_t err = AESPL_GFX_OK;
+
+    switch (rot) {
+        case AESPL_GFX_ROTATE_0:
+        case AESPL_GFX_ROTATE_180:
+            if (dst->c_mode != src->c_mode || dst->width != src->width ||
+                dst->height != src->height) {
+                return AESPL_GFX_BAD_ARG;
+            }
+            if (dst != src) {
+                err = aespl_gfx_merge(dst, src, zero, zero);
+            }
+            if (!err && rot == AESPL_GFX_ROTATE_180) {
+                aespl_gfx_flip_h(dst);
+                aespl_gfx_flip_v(dst);
+            }
+            return err;
+
+        case AESPL_GFX_ROTATE_90:
+            err = aespl_gfx_transpose(dst, src);
+            if (!err) {
+                aespl_gfx_flip_h(dst);
+            }
+            return err;
+
+        case AESPL_GFX_ROTATE_270:
+            err = aespl_gfx_transpose(dst, src);
+            if (!err) {
+                aespl_gfx_flip_v(dst);
+            }
+            return err;
+    }
+
+    return AESPL_GFX_BAD_ARG;
+}
+
+aespl_gfx_err_t aespl_gfx_rotate_tiles(aespl_gfx_buf_t *buf,
+                                       aespl_gfx_rotation_t rot) {
+    if (buf->c_mode != AESPL_GFX_C_MODE_MONO || buf->width % 8 ||
+        buf->height % 8 || rot > AESPL_GFX_ROTATE_270) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    if (rot == AESPL_GFX_ROTATE_0) {
+        return AESPL_GFX_OK;
+    }
+
+    uint8_t tile[8];
+    for (int32_t y = 0; y < buf->height; y += 8) {
+        for (int32_t x = 0; x < buf->width; x += 8) {
+            get_tile(buf, x, y, tile);
+            aespl_gfx_rotate_tile(tile, rot);
+            put_tile(buf, x, y, tile);
+        }
+    }
+
+    mark_all_dirty(buf);
+
+    return AESPL_GFX_OK;
+}
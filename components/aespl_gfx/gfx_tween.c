@@ -0,0 +1,295 @@
+#include "aespl/gfx_tween.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aespl/gfx_animation.h"
+
+// Number of segments of easing tables
+#define EASE_STEPS 32
+
+// Easing functions sampled at EASE_STEPS + 1 points, Q2.14
+static const int16_t ease_lut[][EASE_STEPS + 1] = {
+    // AESPL_GFX_EASE_IN_QUAD
+    {
+        0, 16, 64, 144, 256, 400, 576, 784, 1024, 1296, 1600, 1936, 2304, 2704,
+        3136, 3600, 4096, 4624, 5184, 5776, 6400, 7056, 7744, 8464, 9216,
+        10000, 10816, 11664, 12544, 13456, 14400, 15376, 16384
+    },
+    // AESPL_GFX_EASE_OUT_QUAD
+    {
+        0, 1008, 1984, 2928, 3840, 4720, 5568, 6384, 7168, 7920, 8640, 9328,
+        9984, 10608, 11200, 11760, 12288, 12784, 13248, 13680, 14080, 14448,
+        14784, 15088, 15360, 15600, 15808, 15984, 16128, 16240, 16320, 16368,
+        16384
+    },
+    // AESPL_GFX_EASE_IN_OUT_QUAD
+    {
+        0, 32, 128, 288, 512, 800, 1152, 1568, 2048, 2592, 3200, 3872, 4608,
+        5408, 6272, 7200, 8192, 9184, 10112, 10976, 11776, 12512, 13184, 13792,
+        14336, 14816, 15232, 15584, 15872, 16096, 16256, 16352, 16384
+    },
+    // AESPL_GFX_EASE_IN_CUBIC
+    {
+        0, 0, 4, 14, 32, 62, 108, 172, 256, 364, 500, 666, 864, 1098, 1372,
+        1688, 2048, 2456, 2916, 3430, 4000, 4630, 5324, 6084, 6912, 7812, 8788,
+        9842, 10976, 12194, 13500, 14896, 16384
+    },
+    // AESPL_GFX_EASE_OUT_CUBIC
+    {
+        0, 1488, 2884, 4190, 5408, 6542, 7596, 8572, 9472, 10300, 11060, 11754,
+        12384, 12954, 13468, 13928, 14336, 14696, 15012, 15286, 15520, 15718,
+        15884, 16020, 16128, 16212, 16276, 16322, 16352, 16370, 16380, 16384,
+        16384
+    },
+    // AESPL_GFX_EASE_IN_OUT_CUBIC
+    {
+        0, 2, 16, 54, 128, 250, 432, 686, 1024, 1458, 2000, 2662, 3456, 4394,
+        5488, 6750, 8192, 9634, 10896, 11990, 12928, 13722, 14384, 14926,
+        15360, 15698, 15952, 16134, 16256, 16330, 16368, 16382, 16384
+    },
+    // AESPL_GFX_EASE_OUT_BOUNCE
+    {
+        0, 121, 484, 1089, 1936, 3025, 4356, 5929, 7744, 9801, 12100, 14641,
+        15888, 14689, 13732, 13017, 12544, 12313, 12324, 12577, 13072, 13809,
+        14788, 16009, 15936, 15529, 15364, 15441, 15760, 16321, 16164, 16153,
+        16384
+    },
+    // AESPL_GFX_EASE_OUT_ELASTIC
+    {
+        0, 5917, 13634, 19658, 22350, 21884, 19542, 16853, 14936, 14229, 14570,
+        15463, 16384, 16981, 17147, 16971, 16640, 16330, 16149, 16119, 16198,
+        16318, 16420, 16473, 16475, 16442, 16399, 16366, 16351, 16354, 16367,
+        16381, 16384
+    },
+};
+
+aespl_gfx_fixed_t aespl_gfx_ease(aespl_gfx_ease_t ease, aespl_gfx_fixed_t t) {
+    if (t <= 0) {
+        return 0;
+    }
+    if (t >= AESPL_GFX_FIXED_ONE) {
+        return AESPL_GFX_FIXED_ONE;
+    }
+    if (ease == AESPL_GFX_EASE_LINEAR || ease > AESPL_GFX_EASE_OUT_ELASTIC) {
+        return t;
+    }
+
+    // Linear interpolation between two samples
+    const int16_t *lut = ease_lut[ease - 1];
+    uint32_t pos = (uint32_t)t * EASE_STEPS;
+    uint8_t i = pos >> 16;
+    int32_t frac = pos & 0xffff;
+    int32_t v = lut[i] + (((lut[i + 1] - lut[i]) * frac) >> 16);
+
+    return v << 2;
+}
+
+static inline int32_t lerp(int32_t a, int32_t b, aespl_gfx_fixed_t e) {
+    return a + (int32_t)(((int64_t)(b - a) * e) >> 16);
+}
+
+static inline int32_t clamp(int32_t v, int32_t min, int32_t max) {
+    return v < min ? min : v > max ? max : v;
+}
+
+// Interpolates ARGB888 colors channel by channel
+static uint32_t lerp_color(uint32_t a, uint32_t b, aespl_gfx_fixed_t e) {
+    uint32_t c = 0;
+
+    for (uint8_t shift = 0; shift < 32; shift += 8) {
+        int32_t ch = lerp((a >> shift) & 0xff, (b >> shift) & 0xff, e);
+        c |= (uint32_t)clamp(ch, 0, 0xff) << shift;
+    }
+
+    return c;
+}
+
+static void store_key(const aespl_gfx_track_t *track,
+                      const aespl_gfx_keyframe_t *key) {
+    switch (track->type) {
+        case AESPL_GFX_TRACK_FIXED:
+            *(aespl_gfx_fixed_t *)track->target = key->value.fixed;
+            break;
+        case AESPL_GFX_TRACK_POINT:
+            *(aespl_gfx_point_t *)track->target = key->value.point;
+            break;
+        case AESPL_GFX_TRACK_COLOR:
+            *(uint32_t *)track->target = key->value.color;
+            break;
+    }
+}
+
+aespl_gfx_err_t aespl_gfx_track_init(aespl_gfx_track_t *track,
+                                     aespl_gfx_track_type_t type,
+                                     const aespl_gfx_keyframe_t *keys,
+                                     uint8_t n_keys, void *target) {
+    if (!n_keys || !target || type > AESPL_GFX_TRACK_COLOR) {
+        return AESPL_GFX_BAD_ARG;
+    }
+
+    memset(track, 0, sizeof(*track));
+    track->type = type;
+    track->keys = keys;
+    track->n_keys = n_keys;
+    track->target = target;
+
+    return AESPL_GFX_OK;
+}
+
+void aespl_gfx_track_eval(aespl_gfx_track_t *track, uint32_t time_ms) {
+    const aespl_gfx_keyframe_t *keys = track->keys;
+
+    // Time went back, start over
+    if (track->key_n && time_ms < keys[track->key_n - 1].time_ms) {
+        track->key_n = 0;
+    }
+
+    // Usually no keyframe or one is passed since the last evaluation
+    while (track->key_n < track->n_keys &&
+           time_ms >= keys[track->key_n].time_ms) {
+        track->key_n++;
+    }
+
+    if (!track->key_n) {
+        store_key(track, &keys[0]);
+        return;
+    }
+    if (track->key_n == track->n_keys) {
+        store_key(track, &keys[track->n_keys - 1]);
+        return;
+    }
+
+    const aespl_gfx_keyframe_t *a = &keys[track->key_n - 1];
+    const aespl_gfx_keyframe_t *b = &keys[track->key_n];
+    aespl_gfx_fixed_t t = ((uint64_t)(time_ms - a->time_ms) << 16) /
+                          (b->time_ms - a->time_ms);
+    aespl_gfx_fixed_t e = aespl_gfx_ease(b->ease, t);
+
+    switch (track->type) {
+        case AESPL_GFX_TRACK_FIXED:
+            *(aespl_gfx_fixed_t *)track->target =
+                lerp(a->value.fixed, b->value.fixed, e);
+            break;
+
+        case AESPL_GFX_TRACK_POINT: {
+            aespl_gfx_point_t *p = (aespl_gfx_point_t *)track->target;
+            p->x = clamp(lerp(a->value.point.x, b->value.point.x, e),
+                         INT16_MIN, INT16_MAX);
+            p->y = clamp(lerp(a->value.point.y, b->value.point.y, e),
+                         INT16_MIN, INT16_MAX);
+            break;
+        }
+
+        case AESPL_GFX_TRACK_COLOR:
+            *(uint32_t *)track->target =
+                lerp_color(a->value.color, b->value.color, e);
+            break;
+    }
+}
+
+void aespl_gfx_timeline_init(aespl_gfx_timeline_t *tl) {
+    memset(tl, 0, sizeof(*tl));
+}
+
+void aespl_gfx_timeline_add(aespl_gfx_timeline_t *tl, aespl_gfx_track_t *track,
+                            uint32_t start_ms) {
+    track->start_ms = start_ms;
+    track->key_n = 0;
+
+    // Tracks starting at the same time keep the order they were added in
+    aespl_gfx_track_t **p = &tl->tracks;
+    while (*p && (*p)->start_ms <= start_ms) {
+        p = &(*p)->next;
+    }
+    track->next = *p;
+    *p = track;
+
+    uint32_t end_ms = start_ms + track->keys[track->n_keys - 1].time_ms;
+    if (end_ms > tl->duration_ms) {
+        tl->duration_ms = end_ms;
+    }
+
+    tl->pending = tl->tracks;
+    tl->active = NULL;
+}
+
+void aespl_gfx_timeline_append(aespl_gfx_timeline_t *tl,
+                               aespl_gfx_track_t *track) {
+    tl->group_ms = tl->duration_ms;
+    aespl_gfx_timeline_add(tl, track, tl->group_ms);
+}
+
+void aespl_gfx_timeline_join(aespl_gfx_timeline_t *tl,
+                             aespl_gfx_track_t *track) {
+    aespl_gfx_timeline_add(tl, track, tl->group_ms);
+}
+
+bool aespl_gfx_timeline_eval(aespl_gfx_timeline_t *tl, uint32_t time_ms) {
+    if (time_ms < tl->time_ms) {
+        tl->pending = tl->tracks;
+        tl->active = NULL;
+    }
+    tl->time_ms = time_ms;
+
+    // Started tracks join the end of the active list, so tracks which start
+    // later win when they change the same value
+    aespl_gfx_track_t **tail = &tl->active;
+    while (*tail) {
+        tail = &(*tail)->next_active;
+    }
+    while (tl->pending && tl->pending->start_ms <= time_ms) {
+        *tail = tl->pending;
+        tail = &tl->pending->next_active;
+        *tail = NULL;
+        tl->pending = tl->pending->next;
+    }
+
+    // Finished tracks get their final values and leave
+    for (aespl_gfx_track_t **p = &tl->active; *p;) {
+        aespl_gfx_track_t *track = *p;
+        uint32_t t = time_ms - track->start_ms;
+
+        aespl_gfx_track_eval(track, t);
+
+        if (t >= track->keys[track->n_keys - 1].time_ms) {
+            *p = track->next_active;
+        } else {
+            p = &track->next_active;
+        }
+    }
+
+    return tl->active || tl->pending;
+}
+
+static aespl_gfx_anim_state_t play(void *args, uint32_t frame_n) {
+    aespl_gfx_timeline_t *tl = (aespl_gfx_timeline_t *)args;
+    uint32_t time_ms = (uint64_t)frame_n * 1000 / tl->fps;
+
+    bool more = aespl_gfx_timeline_eval(tl, time_ms);
+    if (tl->cb) {
+        tl->cb(tl->cb_args, time_ms);
+    }
+
+    if (more) {
+        return AESPL_GFX_ANIM_CONTINUE;
+    }
+
+    return tl->loop ? AESPL_GFX_ANIM_RESTART : AESPL_GFX_ANIM_STOP;
+}
+
+aespl_gfx_anim_t aespl_gfx_timeline_play(aespl_gfx_timeline_t *tl, uint8_t fps,
+                                         bool loop, aespl_gfx_timeline_cb_t cb,
+                                         void *cb_args) {
+    if (!fps) {
+        return AESPL_GFX_ANIM_NONE;
+    }
+
+    tl->fps = fps;
+    tl->loop = loop;
+    tl->cb = cb;
+    tl->cb_args = cb_args;
+
+    return aespl_gfx_animate(play, tl, fps);
+}
@@ -7,6 +7,7 @@
 #ifndef _AESPL_GFX_H_
 #define _AESPL_GFX_H_
 
+#include <stdint.h>
 #include <stdio.h>
 
 /**
@@ -7,9 +7,13 @@
 #ifndef _AESPL_GFX_ANIMATION_H_
 #define _AESPL_GFX_ANIMATION_H_
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "aespl/gfx.h"
 #include "aespl/gfx_buffer.h"
+#include "freertos/FreeRTOS.h"
 
 /**
  * Animation states
@@ -27,27 +31,175 @@ typedef aespl_gfx_anim_state_t (*aespl_gfx_animator_t)(void *args,
                                                        uint32_t frame_n);
 
 /**
- * Animation structure
+ * Animation statistics.
  */
 typedef struct {
-    aespl_gfx_animator_t animator;
-    void *args;
-    uint8_t fps;
-    uint32_t frame_n;
-    aespl_gfx_anim_state_t state;
+    uint32_t n_frames;   // number of rendered frames
+    uint32_t n_dropped;  // number of frames skipped to catch up
+    uint32_t min_us;     // minimum animator's time
+    uint32_t avg_us;     // average animator's time
+    uint32_t max_us;     // maximum animator's time
+    uint64_t total_us;   // total animator's time
+} aespl_gfx_anim_stats_t;
 
-} aespl_gfx_animation_t;
+/**
+ * Animation handle.
+ *
+ * All animations are run by a single task, each frame when it is due.
+ * Frames are scheduled at a fixed rate, so the animator's time does not add
+ * up to frame periods. An animator which overruns its period makes the next
+ * frames come late and in a row, unless frame skipping is enabled: then
+ * frames whose time has passed are dropped and their numbers are skipped.
+ * Of frames due at the same time those of animations with higher priority
+ * run first.
+ *
+ * Animations live in a fixed number of slots owned by the animation task.
+ * A handle identifies a slot and its generation, so handles of finished
+ * animations are rejected instead of touching a reused slot. Control
+ * requests are posted atomically and applied by the animation task between
+ * frames; they may be made from any task or ISR, unless stated otherwise.
+ */
+typedef uint32_t aespl_gfx_anim_t;
+
+/**
+ * Handle which never refers to an animation.
+ */
+#define AESPL_GFX_ANIM_NONE 0
 
 /**
  * @brief Starts animation.
  *
+ * Must not be called from an ISR.
+ *
  * @param fn   Animation callback.
  * @param args Callback arguments.
  * @param fps  Frames per second.
  *
- * @return Animation state
+ * @return Animation handle or `AESPL_GFX_ANIM_NONE` in case of error.
+ */
+aespl_gfx_anim_t aespl_gfx_animate(aespl_gfx_animator_t fn, void *args,
+                                   uint8_t fps);
+
+/**
+ * @brief Checks whether an animation has not finished yet.
+ *
+ * @param anim  Animation handle.
+ *
+ * @return Whether the animation is running or paused.
+ */
+bool aespl_gfx_anim_is_active(aespl_gfx_anim_t anim);
+
+/**
+ * @brief Pauses an animation after its current frame.
+ *
+ * @param anim  Animation handle.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_pause(aespl_gfx_anim_t anim);
+
+/**
+ * @brief Resumes a paused animation.
+ *
+ * The next frame runs right away, following ones at the animation's rate.
+ *
+ * @param anim  Animation handle.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_resume(aespl_gfx_anim_t anim);
+
+/**
+ * @brief Makes an animation continue from its first frame.
+ *
+ * A running animation gets the first frame right away, a paused one once it
+ * is resumed.
+ *
+ * @param anim  Animation handle.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_restart(aespl_gfx_anim_t anim);
+
+/**
+ * @brief Changes the frame rate of an animation.
+ *
+ * The next frame keeps its time, following ones come at the new rate.
+ *
+ * @param anim  Animation handle.
+ * @param fps   Frames per second.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_set_fps(aespl_gfx_anim_t anim, uint8_t fps);
+
+/**
+ * @brief Sets the order of an animation's frames due at the same time as
+ *        other animations' ones.
+ *
+ * @param anim      Animation handle.
+ * @param priority  Priority, frames of higher ones run first.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_set_priority(aespl_gfx_anim_t anim,
+                                            uint8_t priority);
+
+/**
+ * @brief Enables or disables dropping of late frames.
+ *
+ * @param anim         Animation handle.
+ * @param skip_frames  Whether to drop frames when late.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_set_skip_frames(aespl_gfx_anim_t anim,
+                                               bool skip_frames);
+
+/**
+ * @brief Gets statistics of an animation.
+ *
+ * Must not be called from an ISR.
+ *
+ * @param anim   Animation handle.
+ * @param stats  Where to put the statistics.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_get_stats(aespl_gfx_anim_t anim,
+                                         aespl_gfx_anim_stats_t *stats);
+
+/**
+ * @brief Stops an animation after its current frame.
+ *
+ * The animator may still be running when the function returns.
+ *
+ * @param anim  Animation handle.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         finished.
+ */
+aespl_gfx_err_t aespl_gfx_anim_stop(aespl_gfx_anim_t anim);
+
+/**
+ * @brief Stops an animation and waits until it finishes.
+ *
+ * Once the function returns, the animator is never called again and its
+ * arguments may be freed. Must not be called from an ISR. Called from an
+ * animator, it does not wait, the animation stops after the current frame.
+ *
+ * @param anim  Animation handle.
+ *
+ * @return Result of the operation, `AESPL_GFX_FAIL` if the animation has
+ *         already finished.
  */
-aespl_gfx_animation_t *aespl_gfx_animate(aespl_gfx_animator_t fn, void *args,
-                                         uint8_t fps);
+aespl_gfx_err_t aespl_gfx_anim_join(aespl_gfx_anim_t anim);
 
 #endif
@@ -0,0 +1,60 @@
+/**
+ * @brief     AESPL graphics, alpha compositing
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * Source pixels are ARGB888, the alpha channel being in the most significant
+ * byte. Blending uses integer math only.
+ */
+
+#ifndef _AESPL_GFX_BLEND_H_
+#define _AESPL_GFX_BLEND_H_
+
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_buffer.h"
+
+/**
+ * Blend modes.
+ */
+typedef enum {
+    AESPL_GFX_BLEND_OVER,      // source over destination
+    AESPL_GFX_BLEND_ADD,       // source added to destination, saturated
+    AESPL_GFX_BLEND_MULTIPLY,  // destination multiplied by source
+} aespl_gfx_blend_t;
+
+/**
+ * @brief Blends two ARGB888 colors.
+ *
+ * @param dst      Destination color.
+ * @param src      Source color.
+ * @param mode     Blend mode.
+ * @param opacity  Opacity of the source, 255 is opaque.
+ *
+ * @return Resulting color.
+ */
+uint32_t aespl_gfx_blend_argb888(uint32_t dst, uint32_t src,
+                                 aespl_gfx_blend_t mode, uint8_t opacity);
+
+/**
+ * @brief Composites an ARGB888 buffer onto another buffer.
+ *
+ * The target buffer must be ARGB888 or RGB565. Parts of the source outside
+ * the target are skipped.
+ *
+ * @param dst      Target buffer.
+ * @param src      Source buffer.
+ * @param pos      Position of the source's top left corner on the target.
+ * @param mode     Blend mode.
+ * @param opacity  Opacity of the whole source applied on top of pixels' own
+ *                 alpha, 255 is opaque.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_blend(aespl_gfx_buf_t *dst,
+                                const aespl_gfx_buf_t *src,
+                                aespl_gfx_point_t pos, aespl_gfx_blend_t mode,
+                                uint8_t opacity);
+
+#endif
@@ -7,35 +7,81 @@
 #ifndef _AESPL_GFX_BUFFER_H_
 #define _AESPL_GFX_BUFFER_H_
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "aespl/gfx.h"
 #include "aespl/gfx_color.h"
 
+/**
+ * Buffer storage types.
+ */
+typedef enum {
+    AESPL_GFX_BUF_STORAGE_CONTIGUOUS,  // header, row pointers and pixels in one block
+    AESPL_GFX_BUF_STORAGE_ROWS,        // each row allocated separately
+    AESPL_GFX_BUF_STORAGE_EXTERNAL,    // contiguous, memory owned by someone else
+} aespl_gfx_buf_storage_t;
+
+/**
+ * Dirty region of a buffer.
+ */
+typedef struct {
+    bool is_dirty;         // whether anything changed
+    aespl_gfx_point_t p1;  // top left corner of changed pixels
+    aespl_gfx_point_t p2;  // bottom right corner of changed pixels
+    uint32_t *rows;        // changed rows, one bit per row
+} aespl_gfx_dirty_t;
+
 /**
  * Buffer.
+ *
+ * Each row is a sequence of `wpr` words. Words are stored in reverse order,
+ * so the leftmost pixel lives in the most significant bits of the last word
+ * of the row.
+ *
+ * RGB565 rows are an exception: they are arrays of 16-bit pixels from left
+ * to right, each pixel in big-endian byte order, the way displays expect
+ * them. A row of odd width ends with a padding pixel.
  */
 typedef struct {
-    uint16_t width;             // columns
-    uint16_t height;            // rows
-    aespl_gfx_c_mode_t c_mode;  // color mode
-    uint8_t ppw;                // pixels per word
-    uint8_t wpr;                // words per row
-    uint32_t **content;         // pixels
+    uint16_t width;                   // columns
+    uint16_t height;                  // rows
+    aespl_gfx_c_mode_t c_mode;        // color mode
+    aespl_gfx_buf_storage_t storage;  // storage type
+    uint8_t ppw;                      // pixels per word
+    uint16_t wpr;                     // words per row
+    uint32_t **content;               // pixels
+    aespl_gfx_dirty_t *dirty;         // dirty region, NULL if not tracked
 } aespl_gfx_buf_t;
 
 /**
  * Array of buffers.
  */
 typedef struct {
-    uint16_t length;            // number of buffers
-    aespl_gfx_c_mode_t c_mode;  // color mode
-    aespl_gfx_buf_t **buffers;  // buffers
+    uint16_t length;                  // number of buffers
+    aespl_gfx_c_mode_t c_mode;        // color mode
+    aespl_gfx_buf_storage_t storage;  // storage type
+    aespl_gfx_buf_t **buffers;        // buffers
 } aespl_gfx_buf_array_t;
 
+/**
+ * Rectangular part of a buffer, references buffer's pixels without copying.
+ */
+typedef struct {
+    aespl_gfx_buf_t *buf;   // parent buffer
+    aespl_gfx_point_t pos;  // top left corner on the parent buffer
+    uint16_t width;         // columns
+    uint16_t height;        // rows
+} aespl_gfx_view_t;
+
 /**
  * @brief Initializes a buffer.
  *
+ * The header, row pointers and pixels are placed into a single memory block.
+ * If the heap is too fragmented to provide such a block, rows are allocated
+ * separately.
+ *
  * @param width   Width in pixels.
  * @param height  Height in pixels.
  * @param c_mode  Color mode.
@@ -45,9 +91,36 @@ typedef struct {
 aespl_gfx_buf_t *aespl_gfx_make_buf(uint16_t width, uint16_t height,
                                     aespl_gfx_c_mode_t c_mode);
 
+/**
+ * @brief Returns size of a memory block required to hold a buffer.
+ *
+ * @param width   Width in pixels.
+ * @param height  Height in pixels.
+ * @param c_mode  Color mode.
+ *
+ * @return Size in bytes.
+ */
+size_t aespl_gfx_buf_size(uint16_t width, uint16_t height,
+                          aespl_gfx_c_mode_t c_mode);
+
+/**
+ * @brief Initializes a buffer inside of a caller-provided memory block.
+ *
+ * @param mem     Word-aligned block of at least `aespl_gfx_buf_size()` bytes.
+ * @param width   Width in pixels.
+ * @param height  Height in pixels.
+ * @param c_mode  Color mode.
+ *
+ * @return Buffer or NULL if the color mode is not supported.
+ */
+aespl_gfx_buf_t *aespl_gfx_init_buf(void *mem, uint16_t width, uint16_t height,
+                                    aespl_gfx_c_mode_t c_mode);
+
 /**
  * @brief Frees resources allocated by `aespl_gfx_make_buf()`.
  *
+ * Memory of buffers made by `aespl_gfx_init_buf()` is left untouched.
+ *
  * @param buf  A buffer.
  */
 void aespl_gfx_free_buf(aespl_gfx_buf_t *buf);
@@ -55,6 +128,8 @@ void aespl_gfx_free_buf(aespl_gfx_buf_t *buf);
 /**
  * @brief Creates a buffers array.
  *
+ * All buffers are placed into a single memory block if possible.
+ *
  * @param length  Number of buffers.
  * @param width   Width of each buffer.
  * @param height  Height of each buffer.
@@ -66,6 +141,35 @@ aespl_gfx_buf_array_t *aespl_gfx_make_buf_array(uint8_t length, uint16_t width,
                                                 uint16_t height,
                                                 aespl_gfx_c_mode_t c_mode);
 
+/**
+ * @brief Returns size of a memory block required to hold a buffers array.
+ *
+ * @param length  Number of buffers.
+ * @param width   Width of each buffer.
+ * @param height  Height of each buffer.
+ * @param c_mode  Color mode.
+ *
+ * @return Size in bytes.
+ */
+size_t aespl_gfx_buf_array_size(uint8_t length, uint16_t width,
+                                uint16_t height, aespl_gfx_c_mode_t c_mode);
+
+/**
+ * @brief Initializes a buffers array inside of a caller-provided memory block.
+ *
+ * @param mem     Word-aligned block of at least `aespl_gfx_buf_array_size()`
+ *                bytes.
+ * @param length  Number of buffers.
+ * @param width   Width of each buffer.
+ * @param height  Height of each buffer.
+ * @param c_mode  Color mode.
+ *
+ * @return Buffers array or NULL if the color mode is not supported.
+ */
+aespl_gfx_buf_array_t *aespl_gfx_init_buf_array(void *mem, uint8_t length,
+                                                uint16_t width, uint16_t height,
+                                                aespl_gfx_c_mode_t c_mode);
+
 /**
  * @brief Frees resources allocated by `aespl_gfx_free_buf_array()`.
  *
@@ -98,6 +202,20 @@ void aespl_gfx_dump_buf(const aespl_gfx_buf_t *buf);
 void aespl_gfx_set_px(aespl_gfx_buf_t *buf, int16_t x, int16_t y,
                       uint32_t color);
 
+/**
+ * @brief Sets a horizontal run of buffer pixels to the same value.
+ *
+ * Pixels are filled by whole words where possible.
+ *
+ * @param buf    A buffer.
+ * @param y      Y position.
+ * @param x1     X position of the first pixel.
+ * @param x2     X position of the last pixel.
+ * @param color  Color value.
+ */
+void aespl_gfx_fill_span(aespl_gfx_buf_t *buf, int16_t y, int32_t x1,
+                         int32_t x2, uint32_t color);
+
 /**
  * @brief Gets buffer pixel's value.
  *
@@ -109,9 +227,29 @@ void aespl_gfx_set_px(aespl_gfx_buf_t *buf, int16_t x, int16_t y,
  */
 uint32_t aespl_gfx_get_px(const aespl_gfx_buf_t *buf, int16_t x, int16_t y);
 
+/**
+ * @brief Gets raw pixels of a range of rows to be sent to a display as is.
+ *
+ * Only RGB565 buffers are supported. The range must occupy a single block of
+ * memory: either it is a single row, or the buffer is not of
+ * `AESPL_GFX_BUF_STORAGE_ROWS` storage and its width is even.
+ *
+ * @param buf  A buffer.
+ * @param y1   First row.
+ * @param y2   Last row.
+ * @param len  Where to put length of the data in bytes.
+ *
+ * @return Pointer to the data or NULL if the range can't be sent as is.
+ */
+const uint8_t *aespl_gfx_get_rows_data(const aespl_gfx_buf_t *buf, int16_t y1,
+                                       int16_t y2, size_t *len);
+
 /**
  * @brief Merges two buffers.
  *
+ * Pixels are copied by whole words when both buffers have the same color mode.
+ * Buffers may be the same.
+ *
  * @param dst      Target buffer.
  * @param src      Source buffer.
  * @param dst_pos  Coordinates on the target buffer,
@@ -139,6 +277,9 @@ aespl_gfx_buf_array_t *aespl_gfx_split(const aespl_gfx_buf_t *src,
 /**
  * @brief Moves buffer's content to a new position.
  *
+ * The content is moved in place, pixels which leave the buffer are lost and
+ * vacated pixels are cleared.
+ *
  * @param buf  A buffer.
  * @param pos  A new position relative to the current one.
  *
@@ -146,4 +287,145 @@ aespl_gfx_buf_array_t *aespl_gfx_split(const aespl_gfx_buf_t *src,
  */
 aespl_gfx_err_t aespl_gfx_move(aespl_gfx_buf_t *buf, aespl_gfx_point_t pos);
 
+/**
+ * @brief Enables or disables tracking of changed pixels.
+ *
+ * Once enabled, whole buffer is considered dirty. Buffers held in a single
+ * memory block keep the dirty region inside the block, so only buffers with
+ * separately allocated rows allocate memory for it.
+ *
+ * @param buf     A buffer.
+ * @param enable  Whether to track changes.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_track_dirty(aespl_gfx_buf_t *buf, bool enable);
+
+/**
+ * @brief Marks a rectangle of a buffer as dirty.
+ *
+ * Use it after modifying buffer's content directly.
+ *
+ * @param buf  A buffer.
+ * @param p1   Top left corner.
+ * @param p2   Bottom right corner.
+ */
+void aespl_gfx_mark_dirty(aespl_gfx_buf_t *buf, aespl_gfx_point_t p1,
+                          aespl_gfx_point_t p2);
+
+/**
+ * @brief Checks whether a buffer's row has changed.
+ *
+ * Rows of buffers which do not track changes are always dirty.
+ *
+ * @param buf  A buffer.
+ * @param y    Row number.
+ *
+ * @return Whether the row has changed.
+ */
+bool aespl_gfx_is_row_dirty(const aespl_gfx_buf_t *buf, int16_t y);
+
+/**
+ * @brief Gets a rectangle containing all changed pixels.
+ *
+ * Buffers which do not track changes are dirty as a whole.
+ *
+ * @param buf  A buffer.
+ * @param p1   Top left corner.
+ * @param p2   Bottom right corner.
+ *
+ * @return Whether anything has changed.
+ */
+bool aespl_gfx_get_dirty(const aespl_gfx_buf_t *buf, aespl_gfx_point_t *p1,
+                         aespl_gfx_point_t *p2);
+
+/**
+ * @brief Marks a whole buffer as clean.
+ *
+ * @param buf  A buffer.
+ */
+void aespl_gfx_reset_dirty(aespl_gfx_buf_t *buf);
+
+/**
+ * @brief Makes a view of a buffer's rectangle.
+ *
+ * @param buf     A buffer.
+ * @param pos     Top left corner on the buffer.
+ * @param width   Width in pixels.
+ * @param height  Height in pixels.
+ *
+ * @return A view.
+ */
+aespl_gfx_view_t aespl_gfx_make_view(aespl_gfx_buf_t *buf,
+                                     aespl_gfx_point_t pos, uint16_t width,
+                                     uint16_t height);
+
+/**
+ * @brief Sets view pixel's value.
+ *
+ * @param view   A view.
+ * @param x      X position relative to the view.
+ * @param y      Y position relative to the view.
+ * @param color  Color value.
+ */
+void aespl_gfx_view_set_px(const aespl_gfx_view_t *view, int16_t x, int16_t y,
+                           uint32_t color);
+
+/**
+ * @brief Gets view pixel's value.
+ *
+ * @param view  A view.
+ * @param x     X position relative to the view.
+ * @param y     Y position relative to the view.
+ *
+ * @return Pixel's value.
+ */
+uint32_t aespl_gfx_view_get_px(const aespl_gfx_view_t *view, int16_t x,
+                               int16_t y);
+
+/**
+ * @brief Gets 32 pixels of a MONO view's row at once.
+ *
+ * Leftmost pixel is returned in the most significant bit. Pixels outside of
+ * the view are zeros.
+ *
+ * @param view  A view.
+ * @param x     X position of the first pixel relative to the view.
+ * @param y     Y position relative to the view.
+ *
+ * @return Pixels.
+ */
+uint32_t aespl_gfx_view_get_word(const aespl_gfx_view_t *view, int16_t x,
+                                 int16_t y);
+
+/**
+ * @brief Copies a view into another view.
+ *
+ * Only parts of the source which are inside of its buffer are copied.
+ *
+ * @param dst      Target view.
+ * @param src      Source view.
+ * @param dst_pos  Coordinates on the target view.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_merge_view(const aespl_gfx_view_t *dst,
+                                     const aespl_gfx_view_t *src,
+                                     aespl_gfx_point_t dst_pos);
+
+/**
+ * @brief Splits a buffer into views.
+ *
+ * Unlike `aespl_gfx_split()` nothing is allocated or copied.
+ *
+ * @param src    A source buffer.
+ * @param num_x  Number of X parts.
+ * @param num_y  Number of Y parts.
+ * @param views  Array of at least `num_x * num_y` views to fill.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_split_view(aespl_gfx_buf_t *src, uint8_t num_x,
+                                     uint8_t num_y, aespl_gfx_view_t *views);
+
 #endif
@@ -8,8 +8,54 @@
 #ifndef _AESPL_GFX_COLOR_H_
 #define _AESPL_GFX_COLOR_H_
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "sdkconfig.h"
+
+/**
+ * Supported color modes. Unsupported modes are compiled out, so that pixel
+ * kernels of single-mode firmware need no branching. All modes are supported
+ * if none is configured.
+ */
+#if defined(CONFIG_AESPL_GFX_C_MODE_MONO) ||   \
+    defined(CONFIG_AESPL_GFX_C_MODE_RGB565) || \
+    defined(CONFIG_AESPL_GFX_C_MODE_ARGB888)
+#define AESPL_GFX_C_MODES_CONFIGURED
+#endif
+
+#ifndef AESPL_GFX_C_MODE_MONO_EN
+#if defined(CONFIG_AESPL_GFX_C_MODE_MONO) || \
+    !defined(AESPL_GFX_C_MODES_CONFIGURED)
+#define AESPL_GFX_C_MODE_MONO_EN 1
+#else
+#define AESPL_GFX_C_MODE_MONO_EN 0
+#endif
+#endif
+
+#ifndef AESPL_GFX_C_MODE_RGB565_EN
+#if defined(CONFIG_AESPL_GFX_C_MODE_RGB565) || \
+    !defined(AESPL_GFX_C_MODES_CONFIGURED)
+#define AESPL_GFX_C_MODE_RGB565_EN 1
+#else
+#define AESPL_GFX_C_MODE_RGB565_EN 0
+#endif
+#endif
+
+#ifndef AESPL_GFX_C_MODE_ARGB888_EN
+#if defined(CONFIG_AESPL_GFX_C_MODE_ARGB888) || \
+    !defined(AESPL_GFX_C_MODES_CONFIGURED)
+#define AESPL_GFX_C_MODE_ARGB888_EN 1
+#else
+#define AESPL_GFX_C_MODE_ARGB888_EN 0
+#endif
+#endif
+
+#define AESPL_GFX_C_MODES_NUM                                \
+    (AESPL_GFX_C_MODE_MONO_EN + AESPL_GFX_C_MODE_RGB565_EN + \
+     AESPL_GFX_C_MODE_ARGB888_EN)
+
 /**
  * Color modes.
  */
@@ -30,4 +76,65 @@ typedef enum {
  */
 uint16_t aespl_gfx_make_rgb565(uint8_t r, uint8_t g, uint8_t b);
 
+/**
+ * @brief Converts an ARGB888 color to RGB565, alpha is dropped.
+ *
+ * @param c  Color.
+ *
+ * @return Converted color.
+ */
+static inline uint16_t aespl_gfx_argb888_to_rgb565(uint32_t c) {
+    return ((c >> 8) & 0xf800) | ((c >> 5) & 0x07e0) | ((c >> 3) & 0x1f);
+}
+
+/**
+ * @brief Converts an RGB565 color to opaque ARGB888.
+ *
+ * @param c  Color.
+ *
+ * @return Converted color.
+ */
+static inline uint32_t aespl_gfx_rgb565_to_argb888(uint16_t c) {
+    uint32_t r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+
+    // Replicate upper bits, so that full intensity stays full
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+
+    return 0xff000000 | r << 16 | g << 8 | b;
+}
+
+/**
+ * @brief Calculates brightness of an ARGB888 color, alpha is ignored.
+ *
+ * @param c  Color.
+ *
+ * @return Brightness, 0..255.
+ */
+static inline uint8_t aespl_gfx_luma(uint32_t c) {
+    return (77 * ((c >> 16) & 0xff) + 150 * ((c >> 8) & 0xff) +
+            29 * (c & 0xff)) >> 8;
+}
+
+/**
+ * @brief Checks whether a color mode is supported by the firmware.
+ *
+ * @param c_mode  Color mode.
+ *
+ * @return Whether the color mode is supported.
+ */
+static inline bool aespl_gfx_c_mode_enabled(aespl_gfx_c_mode_t c_mode) {
+    switch (c_mode) {
+        case AESPL_GFX_C_MODE_MONO:
+            return AESPL_GFX_C_MODE_MONO_EN;
+        case AESPL_GFX_C_MODE_RGB565:
+            return AESPL_GFX_C_MODE_RGB565_EN;
+        case AESPL_GFX_C_MODE_ARGB888:
+            return AESPL_GFX_C_MODE_ARGB888_EN;
+    }
+
+    return false;
+}
+
 #endif
\ No newline at end of file
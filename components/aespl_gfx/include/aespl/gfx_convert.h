@@ -0,0 +1,43 @@
+/**
+ * @brief     AESPL graphics, color mode conversion
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * Colors are converted as follows:
+ *  - MONO pixels become black or white, opaque ones in ARGB888;
+ *  - RGB565 pixels become opaque ARGB888 ones;
+ *  - ARGB888 pixels lose their alpha channel;
+ *  - color pixels become MONO according to their brightness.
+ */
+
+#ifndef _AESPL_GFX_CONVERT_H_
+#define _AESPL_GFX_CONVERT_H_
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_buffer.h"
+
+/**
+ * Dithering methods, used when converting to MONO.
+ */
+typedef enum {
+    AESPL_GFX_DITHER_NONE,       // half-brightness threshold
+    AESPL_GFX_DITHER_ORDERED,    // 4x4 Bayer matrix
+    AESPL_GFX_DITHER_DIFFUSION,  // Floyd-Steinberg error diffusion
+} aespl_gfx_dither_t;
+
+/**
+ * @brief Converts pixels of a buffer into the color mode of another buffer.
+ *
+ * Buffers must have the same size and may have any color modes.
+ *
+ * @param dst     Target buffer.
+ * @param src     Source buffer.
+ * @param dither  Dithering method, ignored unless the target is MONO.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_convert(aespl_gfx_buf_t *dst,
+                                  const aespl_gfx_buf_t *src,
+                                  aespl_gfx_dither_t dither);
+
+#endif
@@ -12,6 +12,11 @@
 #include "aespl/gfx.h"
 #include "aespl/gfx_buffer.h"
 
+/**
+ * Fixed point one returned by trigonometric functions.
+ */
+#define AESPL_GFX_TRIG_ONE 16384
+
 /**
  * Line.
  */
@@ -72,4 +77,142 @@ void aespl_gfx_tri(aespl_gfx_buf_t *buf, const aespl_gfx_point_t p1,
                    const aespl_gfx_point_t p2, const aespl_gfx_point_t p3,
                    uint32_t color);
 
+/**
+ * @brief Draws a horizontal line.
+ *
+ * @param buf    Buffer.
+ * @param p      Leftmost point.
+ * @param len    Length.
+ * @param color  Color.
+ */
+void aespl_gfx_hline(aespl_gfx_buf_t *buf, aespl_gfx_point_t p, uint16_t len,
+                     uint32_t color);
+
+/**
+ * @brief Draws a vertical line.
+ *
+ * @param buf    Buffer.
+ * @param p      Topmost point.
+ * @param len    Length.
+ * @param color  Color.
+ */
+void aespl_gfx_vline(aespl_gfx_buf_t *buf, aespl_gfx_point_t p, uint16_t len,
+                     uint32_t color);
+
+/**
+ * @brief Draws a filled rectangle.
+ *
+ * @param buf    Buffer.
+ * @param p1     Top left point.
+ * @param p2     Bottom right point.
+ * @param color  Color.
+ */
+void aespl_gfx_fill_rect(aespl_gfx_buf_t *buf, aespl_gfx_point_t p1,
+                         aespl_gfx_point_t p2, uint32_t color);
+
+/**
+ * @brief Draws a filled polygon.
+ *
+ * Self-intersecting polygons are filled using the even-odd rule.
+ *
+ * @param buf    Buffer.
+ * @param poly   Points.
+ * @param color  Color.
+ */
+void aespl_gfx_fill_poly(aespl_gfx_buf_t *buf, const aespl_gfx_poly_t *poly,
+                         uint32_t color);
+
+/**
+ * @brief Draws a filled triangle.
+ *
+ * @param buf    Buffer.
+ * @param p1     Point 1.
+ * @param p2     Point 2.
+ * @param p3     Point 3.
+ * @param color  Color.
+ */
+void aespl_gfx_fill_tri(aespl_gfx_buf_t *buf, const aespl_gfx_point_t p1,
+                        const aespl_gfx_point_t p2, const aespl_gfx_point_t p3,
+                        uint32_t color);
+
+/**
+ * @brief Returns sine of an angle.
+ *
+ * @param deg  Angle in degrees.
+ *
+ * @return Sine multiplied by `AESPL_GFX_TRIG_ONE`.
+ */
+int16_t aespl_gfx_sin(int32_t deg);
+
+/**
+ * @brief Returns cosine of an angle.
+ *
+ * @param deg  Angle in degrees.
+ *
+ * @return Cosine multiplied by `AESPL_GFX_TRIG_ONE`.
+ */
+int16_t aespl_gfx_cos(int32_t deg);
+
+/**
+ * @brief Draws a circle.
+ *
+ * @param buf     Buffer.
+ * @param center  Center.
+ * @param r       Radius.
+ * @param color   Color.
+ */
+void aespl_gfx_circle(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                      uint16_t r, uint32_t color);
+
+/**
+ * @brief Draws a filled circle.
+ *
+ * @param buf     Buffer.
+ * @param center  Center.
+ * @param r       Radius.
+ * @param color   Color.
+ */
+void aespl_gfx_fill_circle(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                           uint16_t r, uint32_t color);
+
+/**
+ * @brief Draws an ellipse.
+ *
+ * @param buf     Buffer.
+ * @param center  Center.
+ * @param rx      Horizontal radius.
+ * @param ry      Vertical radius.
+ * @param color   Color.
+ */
+void aespl_gfx_ellipse(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                       uint16_t rx, uint16_t ry, uint32_t color);
+
+/**
+ * @brief Draws a filled ellipse.
+ *
+ * @param buf     Buffer.
+ * @param center  Center.
+ * @param rx      Horizontal radius.
+ * @param ry      Vertical radius.
+ * @param color   Color.
+ */
+void aespl_gfx_fill_ellipse(aespl_gfx_buf_t *buf, aespl_gfx_point_t center,
+                            uint16_t rx, uint16_t ry, uint32_t color);
+
+/**
+ * @brief Draws an arc of a circle.
+ *
+ * Angles are in degrees, 0 points to the right and angles grow clockwise.
+ * The arc goes clockwise from `start` to `end`.
+ *
+ * @param buf     Buffer.
+ * @param center  Center.
+ * @param r       Radius.
+ * @param start   Start angle.
+ * @param end     End angle.
+ * @param color   Color.
+ */
+void aespl_gfx_arc(aespl_gfx_buf_t *buf, aespl_gfx_point_t center, uint16_t r,
+                   int32_t start, int32_t end, uint32_t color);
+
 #endif
@@ -0,0 +1,136 @@
+/**
+ * @brief     AESPL graphics, buffers pool
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * A pool hands out memory from a single preallocated block and releases
+ * everything at once, which keeps the heap from fragmenting when buffers are
+ * created and dropped every frame. Pools are not thread-safe.
+ */
+
+#ifndef _AESPL_GFX_POOL_H_
+#define _AESPL_GFX_POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_buffer.h"
+
+/**
+ * Pool.
+ */
+typedef struct {
+    uint8_t *mem;       // memory block
+    size_t size;        // size of the memory block
+    size_t used;        // bytes in use
+    size_t high_water;  // maximum bytes ever used
+    uint32_t n_fails;   // number of failed allocations
+    bool own_mem;       // whether the memory block was allocated by the pool
+} aespl_gfx_pool_t;
+
+/**
+ * @brief Initializes a pool.
+ *
+ * @param pool  A pool.
+ * @param mem   Word-aligned memory block or NULL to allocate it.
+ * @param size  Size of the memory block.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_pool_init(aespl_gfx_pool_t *pool, void *mem,
+                                    size_t size);
+
+/**
+ * @brief Frees resources allocated by `aespl_gfx_pool_init()`.
+ *
+ * @param pool  A pool.
+ */
+void aespl_gfx_pool_deinit(aespl_gfx_pool_t *pool);
+
+/**
+ * @brief Allocates word-aligned memory from a pool.
+ *
+ * @param pool  A pool.
+ * @param size  Size in bytes.
+ *
+ * @return Memory or NULL if the pool is exhausted.
+ */
+void *aespl_gfx_pool_alloc(aespl_gfx_pool_t *pool, size_t size);
+
+/**
+ * @brief Returns current position of a pool to release memory up to later.
+ *
+ * @param pool  A pool.
+ *
+ * @return Position.
+ */
+size_t aespl_gfx_pool_mark(const aespl_gfx_pool_t *pool);
+
+/**
+ * @brief Releases memory allocated after a position.
+ *
+ * @param pool  A pool.
+ * @param mark  Position returned by `aespl_gfx_pool_mark()`.
+ */
+void aespl_gfx_pool_release(aespl_gfx_pool_t *pool, size_t mark);
+
+/**
+ * @brief Releases all memory of a pool, e.g. at the end of a frame.
+ *
+ * Buffers made by the pool, including their dirty regions, are gone then.
+ *
+ * @param pool  A pool.
+ */
+void aespl_gfx_pool_reset(aespl_gfx_pool_t *pool);
+
+/**
+ * @brief Initializes a buffer allocated from a pool.
+ *
+ * Such buffer, including its dirty region, is never freed individually, it
+ * is released by `aespl_gfx_pool_release()` or `aespl_gfx_pool_reset()`.
+ *
+ * @param pool    A pool.
+ * @param width   Width in pixels.
+ * @param height  Height in pixels.
+ * @param c_mode  Color mode.
+ *
+ * @return Buffer or NULL in case of error.
+ */
+aespl_gfx_buf_t *aespl_gfx_pool_make_buf(aespl_gfx_pool_t *pool,
+                                         uint16_t width, uint16_t height,
+                                         aespl_gfx_c_mode_t c_mode);
+
+/**
+ * @brief Creates a buffers array allocated from a pool.
+ *
+ * @param pool    A pool.
+ * @param length  Number of buffers.
+ * @param width   Width of each buffer.
+ * @param height  Height of each buffer.
+ * @param c_mode  Color mode.
+ *
+ * @returns Buffers array or NULL in case of error
+ */
+aespl_gfx_buf_array_t *aespl_gfx_pool_make_buf_array(aespl_gfx_pool_t *pool,
+                                                     uint8_t length,
+                                                     uint16_t width,
+                                                     uint16_t height,
+                                                     aespl_gfx_c_mode_t c_mode);
+
+/**
+ * @brief Splits a buffer into buffers allocated from a pool.
+ *
+ * @param pool   A pool.
+ * @param src    A source buffer.
+ * @param num_x  Number of X parts.
+ * @param num_y  Number of Y parts.
+ *
+ * @return Buffers array or NULL in case of error.
+ */
+aespl_gfx_buf_array_t *aespl_gfx_pool_split(aespl_gfx_pool_t *pool,
+                                            const aespl_gfx_buf_t *src,
+                                            uint8_t num_x, uint8_t num_y);
+
+#endif
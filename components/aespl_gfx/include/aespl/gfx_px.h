@@ -0,0 +1,254 @@
+/**
+ * @brief     AESPL graphics, per color mode pixel kernels
+ *
+ * Kernels do not check boundaries and do not track dirty regions, callers
+ * are expected to clip coordinates once and mark dirty regions afterwards.
+ *
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ */
+
+#ifndef _AESPL_GFX_PX_H_
+#define _AESPL_GFX_PX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_color.h"
+
+#define AESPL_GFX_PX_INLINE static inline __attribute__((always_inline))
+
+/**
+ * @brief Sets a pixel of a MONO buffer.
+ *
+ * @param buf    Buffer.
+ * @param x      X position, must be inside the buffer.
+ * @param y      Y position, must be inside the buffer.
+ * @param color  Color, any non-zero value sets the pixel.
+ *
+ * @return Whether the pixel has been changed.
+ */
+AESPL_GFX_PX_INLINE bool aespl_gfx_mono_set_px(aespl_gfx_buf_t *buf,
+                                               uint16_t x, uint16_t y,
+                                               uint32_t color) {
+    uint32_t *w = &buf->content[y][buf->wpr - 1 - x / 32];
+    uint32_t bit = 0x80000000U >> (x % 32);
+    uint32_t prev = *w;
+    *w = color ? prev | bit : prev & ~bit;
+    return *w != prev;
+}
+
+/**
+ * @brief Gets a pixel of a MONO buffer.
+ *
+ * @param buf  Buffer.
+ * @param x    X position, must be inside the buffer.
+ * @param y    Y position, must be inside the buffer.
+ *
+ * @return Pixel's color, 0 or 1.
+ */
+AESPL_GFX_PX_INLINE uint32_t aespl_gfx_mono_get_px(const aespl_gfx_buf_t *buf,
+                                                   uint16_t x, uint16_t y) {
+    return 1 & (buf->content[y][buf->wpr - 1 - x / 32] >> (31 - x % 32));
+}
+
+/**
+ * Converts an RGB565 color to or from big-endian byte order of buffers.
+ */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define AESPL_GFX_RGB565_BE(c) ((uint16_t)__builtin_bswap16(c))
+#else
+#define AESPL_GFX_RGB565_BE(c) ((uint16_t)(c))
+#endif
+
+/**
+ * @brief Sets a pixel of an RGB565 buffer.
+ *
+ * @param buf    Buffer.
+ * @param x      X position, must be inside the buffer.
+ * @param y      Y position, must be inside the buffer.
+ * @param color  Color, only 16 lower bits are used.
+ *
+ * @return Whether the pixel has been changed.
+ */
+AESPL_GFX_PX_INLINE bool aespl_gfx_rgb565_set_px(aespl_gfx_buf_t *buf,
+                                                 uint16_t x, uint16_t y,
+                                                 uint32_t color) {
+    uint16_t *px = (uint16_t *)buf->content[y] + x;
+    uint16_t prev = *px;
+    *px = AESPL_GFX_RGB565_BE(color);
+    return *px != prev;
+}
+
+/**
+ * @brief Gets a pixel of an RGB565 buffer.
+ *
+ * @param buf  Buffer.
+ * @param x    X position, must be inside the buffer.
+ * @param y    Y position, must be inside the buffer.
+ *
+ * @return Pixel's color.
+ */
+AESPL_GFX_PX_INLINE uint32_t aespl_gfx_rgb565_get_px(const aespl_gfx_buf_t *buf,
+                                                     uint16_t x, uint16_t y) {
+    return AESPL_GFX_RGB565_BE(((const uint16_t *)buf->content[y])[x]);
+}
+
+/**
+ * @brief Sets a pixel of an ARGB888 buffer.
+ *
+ * @param buf    Buffer.
+ * @param x      X position, must be inside the buffer.
+ * @param y      Y position, must be inside the buffer.
+ * @param color  Color.
+ *
+ * @return Whether the pixel has been changed.
+ */
+AESPL_GFX_PX_INLINE bool aespl_gfx_argb888_set_px(aespl_gfx_buf_t *buf,
+                                                  uint16_t x, uint16_t y,
+                                                  uint32_t color) {
+    uint32_t *w = &buf->content[y][buf->wpr - 1 - x];
+    uint32_t prev = *w;
+    *w = color;
+    return color != prev;
+}
+
+/**
+ * @brief Gets a pixel of an ARGB888 buffer.
+ *
+ * @param buf  Buffer.
+ * @param x    X position, must be inside the buffer.
+ * @param y    Y position, must be inside the buffer.
+ *
+ * @return Pixel's color.
+ */
+AESPL_GFX_PX_INLINE uint32_t aespl_gfx_argb888_get_px(
+    const aespl_gfx_buf_t *buf, uint16_t x, uint16_t y) {
+    return buf->content[y][buf->wpr - 1 - x];
+}
+
+/**
+ * @brief Sets a pixel using the kernel of a color mode.
+ *
+ * If the color mode is a compile time constant, or the firmware supports a
+ * single color mode, the call reduces to the mode's kernel.
+ *
+ * @param c_mode  Buffer's color mode.
+ * @param buf     Buffer.
+ * @param x       X position, must be inside the buffer.
+ * @param y       Y position, must be inside the buffer.
+ * @param color   Color.
+ *
+ * @return Whether the pixel has been changed.
+ */
+AESPL_GFX_PX_INLINE bool aespl_gfx_mode_set_px(aespl_gfx_c_mode_t c_mode,
+                                               aespl_gfx_buf_t *buf,
+                                               uint16_t x, uint16_t y,
+                                               uint32_t color) {
+#if AESPL_GFX_C_MODES_NUM == 1
+    (void)c_mode;
+#if AESPL_GFX_C_MODE_MONO_EN
+    return aespl_gfx_mono_set_px(buf, x, y, color);
+#elif AESPL_GFX_C_MODE_RGB565_EN
+    return aespl_gfx_rgb565_set_px(buf, x, y, color);
+#else
+    return aespl_gfx_argb888_set_px(buf, x, y, color);
+#endif
+#else
+    switch (c_mode) {
+#if AESPL_GFX_C_MODE_MONO_EN
+        case AESPL_GFX_C_MODE_MONO:
+            return aespl_gfx_mono_set_px(buf, x, y, color);
+#endif
+#if AESPL_GFX_C_MODE_RGB565_EN
+        case AESPL_GFX_C_MODE_RGB565:
+            return aespl_gfx_rgb565_set_px(buf, x, y, color);
+#endif
+#if AESPL_GFX_C_MODE_ARGB888_EN
+        case AESPL_GFX_C_MODE_ARGB888:
+            return aespl_gfx_argb888_set_px(buf, x, y, color);
+#endif
+        default:
+            return false;
+    }
+#endif
+}
+
+/**
+ * @brief Gets a pixel using the kernel of a color mode.
+ *
+ * @param c_mode  Buffer's color mode.
+ * @param buf     Buffer.
+ * @param x       X position, must be inside the buffer.
+ * @param y       Y position, must be inside the buffer.
+ *
+ * @return Pixel's color.
+ */
+AESPL_GFX_PX_INLINE uint32_t aespl_gfx_mode_get_px(aespl_gfx_c_mode_t c_mode,
+                                                   const aespl_gfx_buf_t *buf,
+                                                   uint16_t x, uint16_t y) {
+#if AESPL_GFX_C_MODES_NUM == 1
+    (void)c_mode;
+#if AESPL_GFX_C_MODE_MONO_EN
+    return aespl_gfx_mono_get_px(buf, x, y);
+#elif AESPL_GFX_C_MODE_RGB565_EN
+    return aespl_gfx_rgb565_get_px(buf, x, y);
+#else
+    return aespl_gfx_argb888_get_px(buf, x, y);
+#endif
+#else
+    switch (c_mode) {
+#if AESPL_GFX_C_MODE_MONO_EN
+        case AESPL_GFX_C_MODE_MONO:
+            return aespl_gfx_mono_get_px(buf, x, y);
+#endif
+#if AESPL_GFX_C_MODE_RGB565_EN
+        case AESPL_GFX_C_MODE_RGB565:
+            return aespl_gfx_rgb565_get_px(buf, x, y);
+#endif
+#if AESPL_GFX_C_MODE_ARGB888_EN
+        case AESPL_GFX_C_MODE_ARGB888:
+            return aespl_gfx_argb888_get_px(buf, x, y);
+#endif
+        default:
+            return 0x0;
+    }
+#endif
+}
+
+/**
+ * Instantiates a function per supported color mode and calls the one that
+ * matches `c_mode`. The function receives the color mode as a compile time
+ * constant first argument, so pixel kernels called with it are inlined
+ * without branching. Any return value is discarded.
+ */
+#if AESPL_GFX_C_MODES_NUM == 1
+#if AESPL_GFX_C_MODE_MONO_EN
+#define AESPL_GFX_C_MODE_ONLY AESPL_GFX_C_MODE_MONO
+#elif AESPL_GFX_C_MODE_RGB565_EN
+#define AESPL_GFX_C_MODE_ONLY AESPL_GFX_C_MODE_RGB565
+#else
+#define AESPL_GFX_C_MODE_ONLY AESPL_GFX_C_MODE_ARGB888
+#endif
+#define AESPL_GFX_DISPATCH(c_mode, fn, ...) \
+    ((void)(c_mode), (void)fn(AESPL_GFX_C_MODE_ONLY, __VA_ARGS__))
+#else
+#define AESPL_GFX_DISPATCH_CASE(en, mode, fn, ...) \
+    if ((en) && c_mode_ == (mode)) {               \
+        (void)fn(mode, __VA_ARGS__);               \
+    }
+#define AESPL_GFX_DISPATCH(c_mode, fn, ...)                                   \
+    do {                                                                      \
+        aespl_gfx_c_mode_t c_mode_ = (c_mode);                                \
+        AESPL_GFX_DISPATCH_CASE(AESPL_GFX_C_MODE_MONO_EN,                     \
+                                AESPL_GFX_C_MODE_MONO, fn, __VA_ARGS__)       \
+        else AESPL_GFX_DISPATCH_CASE(AESPL_GFX_C_MODE_RGB565_EN,              \
+                                     AESPL_GFX_C_MODE_RGB565, fn, __VA_ARGS__) \
+        else AESPL_GFX_DISPATCH_CASE(AESPL_GFX_C_MODE_ARGB888_EN,             \
+                                     AESPL_GFX_C_MODE_ARGB888, fn,            \
+                                     __VA_ARGS__)                             \
+    } while (0)
+#endif
+
+#endif
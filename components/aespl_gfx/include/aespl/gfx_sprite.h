@@ -0,0 +1,209 @@
+/**
+ * @brief     AESPL graphics, sprites
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * Frames of sprites are rectangles of a sprite sheet, a single buffer. Zero
+ * pixels of frames are transparent. A layer composites its sprites over a
+ * background in z-order. Only the rows covered by sprites which have moved,
+ * changed frames or visibility since the last drawing are composited again,
+ * MONO sprites being copied by whole words. Collisions are detected by
+ * AND-ing words of sprites' masks.
+ *
+ * Sprites and layers are not thread safe, a layer and its sprites must be
+ * changed by the task that draws it.
+ */
+
+#ifndef _AESPL_GFX_SPRITE_H_
+#define _AESPL_GFX_SPRITE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_buffer.h"
+
+/**
+ * Frame of a sprite sheet.
+ */
+typedef struct {
+    aespl_gfx_point_t pos;  // top left corner on the sheet
+    uint16_t width;         // columns
+    uint16_t height;        // rows
+} aespl_gfx_sprite_frame_t;
+
+/**
+ * Sprite sheet.
+ */
+typedef struct {
+    aespl_gfx_buf_t *buf;                    // pixels of frames
+    aespl_gfx_buf_t *mask;                   // opaque pixels, MONO
+    const aespl_gfx_sprite_frame_t *frames;  // frames
+    uint16_t n_frames;                       // number of frames
+} aespl_gfx_sprite_sheet_t;
+
+/**
+ * Sprite.
+ *
+ * Position, frame, z-order and visibility may be changed directly, they are
+ * applied by the next drawing of the layer.
+ */
+typedef struct aespl_gfx_sprite {
+    const aespl_gfx_sprite_sheet_t *sheet;  // sprite sheet
+    uint16_t frame;                         // current frame
+    aespl_gfx_point_t pos;                  // top left corner on the layer
+    int8_t z;                               // higher ones cover lower ones
+    bool visible;                           // whether to draw the sprite
+    bool drawn;                             // whether drawn last time
+    uint16_t drawn_frame;                   // frame drawn last time
+    aespl_gfx_point_t drawn_pos;            // position drawn last time
+    int8_t drawn_z;                         // z-order drawn last time
+    struct aespl_gfx_sprite *next;          // next sprite by z-order
+} aespl_gfx_sprite_t;
+
+/**
+ * Span of a layer's row to composite.
+ */
+typedef struct {
+    int16_t x1;  // first column
+    int16_t x2;  // last column, less than x1 if there is nothing to do
+} aespl_gfx_sprite_span_t;
+
+/**
+ * Layer of sprites.
+ */
+typedef struct {
+    uint16_t width;                  // columns
+    uint16_t height;                 // rows
+    aespl_gfx_c_mode_t c_mode;       // color mode
+    aespl_gfx_buf_t *bg;             // background, NULL for blank
+    aespl_gfx_sprite_t *sprites;     // sprites ordered by z-order
+    aespl_gfx_sprite_span_t *spans;  // parts of rows to composite
+    aespl_gfx_buf_t *row;            // row being composited
+} aespl_gfx_sprite_layer_t;
+
+/**
+ * @brief Initializes a sprite sheet.
+ *
+ * Color sheets get a mask of their non-zero pixels, MONO sheets are masks
+ * themselves.
+ *
+ * @param sheet     Sprite sheet.
+ * @param buf       Pixels of frames.
+ * @param frames    Frames, must be inside the buffer.
+ * @param n_frames  Number of frames.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_sprite_sheet_init(
+    aespl_gfx_sprite_sheet_t *sheet, aespl_gfx_buf_t *buf,
+    const aespl_gfx_sprite_frame_t *frames, uint16_t n_frames);
+
+/**
+ * @brief Frees resources of a sprite sheet, the buffer is left intact.
+ *
+ * @param sheet  Sprite sheet.
+ */
+void aespl_gfx_sprite_sheet_deinit(aespl_gfx_sprite_sheet_t *sheet);
+
+/**
+ * @brief Initializes a visible sprite showing the first frame of a sheet.
+ *
+ * @param sprite  Sprite.
+ * @param sheet   Sprite sheet.
+ */
+void aespl_gfx_sprite_init(aespl_gfx_sprite_t *sprite,
+                           const aespl_gfx_sprite_sheet_t *sheet);
+
+/**
+ * @brief Checks whether opaque pixels of two visible sprites overlap.
+ *
+ * @param a  Sprite.
+ * @param b  Another sprite.
+ *
+ * @return Whether the sprites collide.
+ */
+bool aespl_gfx_sprite_collide(const aespl_gfx_sprite_t *a,
+                              const aespl_gfx_sprite_t *b);
+
+/**
+ * @brief Initializes a layer of sprites.
+ *
+ * @param layer   Layer.
+ * @param width   Width, usually the target buffer's one.
+ * @param height  Height, usually the target buffer's one.
+ * @param c_mode  Color mode of the target buffer and sprite sheets.
+ * @param bg      Background of the same size, NULL for blank.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_sprite_layer_init(aespl_gfx_sprite_layer_t *layer,
+                                            uint16_t width, uint16_t height,
+                                            aespl_gfx_c_mode_t c_mode,
+                                            aespl_gfx_buf_t *bg);
+
+/**
+ * @brief Frees resources of a layer, sprites are left intact.
+ *
+ * @param layer  Layer.
+ */
+void aespl_gfx_sprite_layer_deinit(aespl_gfx_sprite_layer_t *layer);
+
+/**
+ * @brief Adds a sprite to a layer.
+ *
+ * @param layer   Layer.
+ * @param sprite  Sprite, must not belong to another layer.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_sprite_layer_add(aespl_gfx_sprite_layer_t *layer,
+                                           aespl_gfx_sprite_t *sprite);
+
+/**
+ * @brief Removes a sprite from a layer.
+ *
+ * The sprite disappears on the next drawing.
+ *
+ * @param layer   Layer.
+ * @param sprite  Sprite.
+ */
+void aespl_gfx_sprite_layer_remove(aespl_gfx_sprite_layer_t *layer,
+                                   aespl_gfx_sprite_t *sprite);
+
+/**
+ * @brief Makes the next drawing composite a whole layer.
+ *
+ * Call it after the background or the target buffer has been changed.
+ *
+ * @param layer  Layer.
+ */
+void aespl_gfx_sprite_layer_invalidate(aespl_gfx_sprite_layer_t *layer);
+
+/**
+ * @brief Draws changes of a layer since its last drawing.
+ *
+ * The target buffer must keep the last drawn content, like buffers of a
+ * preserving swap chain do. Rows are marked dirty only if their pixels
+ * actually change.
+ *
+ * @param layer  Layer.
+ * @param dst    Target buffer of the layer's size and color mode.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_sprite_layer_draw(aespl_gfx_sprite_layer_t *layer,
+                                            aespl_gfx_buf_t *dst);
+
+/**
+ * @brief Finds a sprite of a layer which collides with a given one.
+ *
+ * @param layer   Layer.
+ * @param sprite  Sprite, may belong to the layer.
+ *
+ * @return The first colliding sprite by z-order or NULL.
+ */
+aespl_gfx_sprite_t *aespl_gfx_sprite_layer_collide(
+    const aespl_gfx_sprite_layer_t *layer, const aespl_gfx_sprite_t *sprite);
+
+#endif
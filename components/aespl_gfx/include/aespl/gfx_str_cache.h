@@ -0,0 +1,101 @@
+/**
+ * @brief     AESPL graphics, rendered strings cache
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * A cache keeps buffers made by rendering strings and hands them out to
+ * several users at once. Cached buffers are shared, so they must not be
+ * modified. Least recently used buffers are dropped when the cache grows
+ * beyond its budget. A cache may be used from several tasks.
+ */
+
+#ifndef _AESPL_GFX_STR_CACHE_H_
+#define _AESPL_GFX_STR_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_text.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+typedef struct aespl_gfx_str_cache_entry aespl_gfx_str_cache_entry_t;
+
+/**
+ * Rendered strings cache.
+ */
+typedef struct {
+    size_t budget;                      // maximum bytes of cached buffers
+    size_t used;                        // bytes of cached buffers
+    uint32_t n_hits;                    // number of found strings
+    uint32_t n_misses;                  // number of rendered strings
+    uint32_t n_evictions;               // number of dropped strings
+    aespl_gfx_str_cache_entry_t *head;  // most recently used entry
+    aespl_gfx_str_cache_entry_t *tail;  // least recently used entry
+    SemaphoreHandle_t lock;             // protects everything above
+} aespl_gfx_str_cache_t;
+
+/**
+ * @brief Initializes a cache.
+ *
+ * @param cache   Cache.
+ * @param budget  Maximum bytes of cached buffers, including their headers.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_str_cache_init(aespl_gfx_str_cache_t *cache,
+                                         size_t budget);
+
+/**
+ * @brief Frees resources of a cache.
+ *
+ * All buffers got from the cache must be released before.
+ *
+ * @param cache  Cache.
+ */
+void aespl_gfx_str_cache_deinit(aespl_gfx_str_cache_t *cache);
+
+/**
+ * @brief Gets a rendered string, rendering it if it is not cached yet.
+ *
+ * The buffer is the same as one made by `aespl_gfx_make_str_buf()` and must
+ * be released by `aespl_gfx_str_cache_release()`.
+ *
+ * Buffers being used are never dropped, so the cache may exceed its budget
+ * until they are released. A string which alone exceeds the budget is not
+ * cached.
+ *
+ * @param cache   Cache.
+ * @param c_mode  Color mode.
+ * @param font    Font.
+ * @param str     String.
+ * @param color   Color.
+ * @param space   Space between characters.
+ *
+ * @return Read-only buffer or NULL in case of error.
+ */
+const aespl_gfx_buf_t *aespl_gfx_str_cache_get(aespl_gfx_str_cache_t *cache,
+                                               aespl_gfx_c_mode_t c_mode,
+                                               const aespl_gfx_font_t *font,
+                                               const char *str,
+                                               uint32_t color, uint8_t space);
+
+/**
+ * @brief Releases a buffer got from a cache.
+ *
+ * @param cache  Cache.
+ * @param buf    Buffer.
+ */
+void aespl_gfx_str_cache_release(aespl_gfx_str_cache_t *cache,
+                                 const aespl_gfx_buf_t *buf);
+
+/**
+ * @brief Drops all cached strings which are not being used.
+ *
+ * @param cache  Cache.
+ */
+void aespl_gfx_str_cache_clear(aespl_gfx_str_cache_t *cache);
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @brief     AESPL graphics, swap chain
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * A swap chain lets frames be rendered while previous ones are being sent to
+ * a display. The render side acquires a back buffer, draws into it and
+ * presents it. A flush task sends presented buffers to the display in order
+ * and returns them to the chain. On multi-core chips the flush task runs on
+ * its own core.
+ */
+
+#ifndef _AESPL_GFX_SWAPCHAIN_H_
+#define _AESPL_GFX_SWAPCHAIN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_buffer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+/**
+ * Flush callback, sends a buffer to a display.
+ *
+ * Buffers track changed pixels, so the callback may send only them and mark
+ * the buffer as clean, as `aespl_max7219_matrix_draw()` does.
+ */
+typedef void (*aespl_gfx_flush_t)(void *args, aespl_gfx_buf_t *buf);
+
+/**
+ * Swap chain.
+ */
+typedef struct {
+    aespl_gfx_buf_array_t *bufs;  // buffers
+    bool preserve;                // whether back buffers get the last frame
+    aespl_gfx_buf_t *last;        // last presented buffer
+    QueueHandle_t free_q;         // buffers ready to be drawn
+    QueueHandle_t present_q;      // buffers waiting to be flushed
+    SemaphoreHandle_t done;       // given when the flush task ends
+    aespl_gfx_flush_t flush;      // flush callback
+    void *flush_args;             // flush callback arguments
+} aespl_gfx_swapchain_t;
+
+/**
+ * @brief Initializes a swap chain and starts its flush task.
+ *
+ * With `preserve` set each acquired buffer contains the last presented
+ * frame, so frames may be drawn incrementally. Otherwise frames must be
+ * drawn from scratch and acquired buffers are marked as changed entirely.
+ *
+ * @param sc          Swap chain.
+ * @param length      Number of buffers, at least 2.
+ * @param width       Width of buffers.
+ * @param height      Height of buffers.
+ * @param c_mode      Color mode.
+ * @param preserve    Whether acquired buffers get the last presented frame.
+ * @param flush       Flush callback.
+ * @param flush_args  Flush callback arguments.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_swapchain_init(aespl_gfx_swapchain_t *sc,
+                                         uint8_t length, uint16_t width,
+                                         uint16_t height,
+                                         aespl_gfx_c_mode_t c_mode,
+                                         bool preserve, aespl_gfx_flush_t flush,
+                                         void *flush_args);
+
+/**
+ * @brief Stops the flush task of a swap chain and frees its resources.
+ *
+ * Presented buffers are flushed before. No buffer may be held by the render
+ * side.
+ *
+ * @param sc  Swap chain.
+ */
+void aespl_gfx_swapchain_deinit(aespl_gfx_swapchain_t *sc);
+
+/**
+ * @brief Acquires a back buffer to draw a frame into.
+ *
+ * Acquiring and presenting must be done by a single task.
+ *
+ * @param sc       Swap chain.
+ * @param timeout  Maximum number of ticks to wait for a free buffer.
+ *
+ * @return Buffer or NULL if no buffer got free in time.
+ */
+aespl_gfx_buf_t *aespl_gfx_swapchain_acquire(aespl_gfx_swapchain_t *sc,
+                                             TickType_t timeout);
+
+/**
+ * @brief Hands an acquired buffer over to the flush task.
+ *
+ * The buffer must not be touched by the render side afterwards.
+ *
+ * @param sc   Swap chain.
+ * @param buf  Buffer.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_swapchain_present(aespl_gfx_swapchain_t *sc,
+                                            aespl_gfx_buf_t *buf);
+
+#endif
@@ -10,6 +10,7 @@
 #include <stdio.h>
 
 #include "aespl/gfx_buffer.h"
+#include "aespl/gfx_pool.h"
 
 /**
  * Font widths.
@@ -19,8 +20,40 @@ typedef enum {
     AESPL_GFX_FONT_WIDTH_16 = 16,
 } aespl_gfx_font_width_t;
 
+/**
+ * Encodings of sparse fonts' glyphs.
+ *
+ * AESPL_GFX_FONT_ENC_RAW: each row of a glyph takes `(width + 7) / 8` bytes,
+ * the leftmost pixel in the most significant bit of the first byte.
+ *
+ * AESPL_GFX_FONT_ENC_RLE: pixels of a glyph, row by row, are runs of
+ * alternating color starting with an empty one. A run length is a sequence of
+ * 4-bit nibbles, high nibble of a byte first, summed up until a nibble less
+ * than 15. A glyph starts at a byte boundary.
+ */
+typedef enum {
+    AESPL_GFX_FONT_ENC_RAW,
+    AESPL_GFX_FONT_ENC_RLE,
+} aespl_gfx_font_enc_t;
+
+/**
+ * Glyph of a sparse font.
+ */
+typedef struct {
+    uint32_t code;    // Unicode code point
+    uint32_t offset;  // offset of the glyph's data in the font's bitmap
+    uint8_t width;    // number of columns, up to 32
+    uint8_t height;   // number of rows
+    uint8_t top;      // number of empty rows above the glyph
+} aespl_gfx_glyph_t;
+
 /**
  * Font.
+ *
+ * A dense font covers a range of single byte character codes, each of them
+ * taking the same space in the content. A sparse font has `glyphs` set and
+ * contains only the glyphs it needs, strings drawn by it are UTF-8. Sparse
+ * fonts are made from BDF ones by `tools/bdf2font.py`.
  */
 typedef struct {
     uint8_t ascii_offset;  // char code offset relative to ASCII table
@@ -31,6 +64,10 @@ typedef struct {
         const uint8_t *c8;    // pointer to 1-byte content
         const uint16_t *c16;  // pointer to 2-byte content
     } content;
+    uint16_t n_glyphs;                // number of glyphs of a sparse font
+    const aespl_gfx_glyph_t *glyphs;  // glyphs sorted by code point
+    const uint8_t *bitmap;            // data of glyphs
+    aespl_gfx_font_enc_t enc;         // encoding of glyphs' data
 } aespl_gfx_font_t;
 
 /**
@@ -39,13 +76,13 @@ typedef struct {
  * @param buf    Buffer.
  * @param font   Font.
  * @param pos    Coordinates.
- * @param ch     Character.
+ * @param ch     Character code or, for a sparse font, code point.
  * @param color  Color.
  *
  * @return Width of drawn character or `aespl_gfx_err_t` in case of error.
  */
 int8_t aespl_gfx_putc(aespl_gfx_buf_t *buf, const aespl_gfx_font_t *font,
-                      aespl_gfx_point_t pos, uint8_t ch, uint32_t color);
+                      aespl_gfx_point_t pos, uint32_t ch, uint32_t color);
 
 /**
  * @brief Draws a string.
@@ -53,7 +90,7 @@ int8_t aespl_gfx_putc(aespl_gfx_buf_t *buf, const aespl_gfx_font_t *font,
  * @param buf    Buffer.
  * @param font   Font.
  * @param pos    Coordinates.
- * @param s      String.
+ * @param s      String, UTF-8 for a sparse font.
  * @param color  Color.
  * @param space  Space between characters.
  *
@@ -68,17 +105,30 @@ aespl_gfx_point_t aespl_gfx_puts(aespl_gfx_buf_t *buf,
  * @brief Returns width of a character.
  *
  * @param font  Font.
- * @param ch    Character.
+ * @param ch    Character code or, for a sparse font, code point.
  *
  * @return Character's width or `aespl_gfx_err_t` in case of error
  */
-int8_t aespl_gfx_ch_width(const aespl_gfx_font_t *font, char ch);
+int8_t aespl_gfx_ch_width(const aespl_gfx_font_t *font, uint32_t ch);
+
+/**
+ * @brief Gets the next character of a string and advances the string.
+ *
+ * Strings are UTF-8 for sparse fonts and single byte for dense ones.
+ * Malformed UTF-8 sequences are skipped byte by byte, each giving U+FFFD.
+ *
+ * @param font  Font.
+ * @param s     String.
+ *
+ * @return Character code or, for a sparse font, code point.
+ */
+uint32_t aespl_gfx_next_char(const aespl_gfx_font_t *font, const char **s);
 
 /**
  * @brief Get width of a string.
  *
  * @param font   Font.
- * @param str    String.
+ * @param str    String, UTF-8 for a sparse font.
  * @param space  Space between characters.
  *
  * @return String's width or `aespl_gfx_err_t` in case of error.
@@ -102,4 +152,22 @@ aespl_gfx_buf_t *aespl_gfx_make_str_buf(aespl_gfx_c_mode_t c_mode,
                                         const char *str, uint32_t color,
                                         uint8_t space);
 
+/**
+ * @brief Creates a graphics buffer in a pool and put a string into it.
+ *
+ * @param pool    A pool.
+ * @param c_mode  Buffer color mode.
+ * @param font    Font.
+ * @param str     String.
+ * @param color   Text color.
+ * @param space   Space between characters.
+ *
+ * @return Buffer or NULL in case of error
+ */
+aespl_gfx_buf_t *aespl_gfx_pool_make_str_buf(aespl_gfx_pool_t *pool,
+                                             aespl_gfx_c_mode_t c_mode,
+                                             const aespl_gfx_font_t *font,
+                                             const char *str, uint32_t color,
+                                             uint8_t space);
+
 #endif
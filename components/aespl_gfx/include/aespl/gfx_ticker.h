@@ -0,0 +1,138 @@
+/**
+ * @brief     AESPL graphics, text ticker
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * A ticker scrolls text from right to left through a display-wide buffer.
+ * Each step moves the buffer by one column and draws only the newly exposed
+ * column of the current character, so memory does not depend on the length
+ * of the text. Text may be appended while the ticker is running.
+ */
+
+#ifndef _AESPL_GFX_TICKER_H_
+#define _AESPL_GFX_TICKER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_animation.h"
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_text.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/**
+ * Frame callback, called after each step of a running ticker.
+ */
+typedef void (*aespl_gfx_ticker_cb_t)(void *args, const aespl_gfx_buf_t *buf);
+
+/**
+ * Ticker.
+ */
+typedef struct {
+    aespl_gfx_buf_t *buf;          // visible part of the text
+    aespl_gfx_buf_t *glyph;        // current character, MONO
+    const aespl_gfx_font_t *font;  // font
+    uint32_t color;                // text color
+    uint8_t space;                 // space between characters
+    uint8_t ch_width;              // width of the current character
+    uint16_t col;                  // next column of the current character
+    uint16_t cols;                 // columns of the character and the space
+    char *text;                    // queue of characters to show
+    size_t text_size;              // capacity of the queue
+    size_t text_head;              // position of the first queued character
+    size_t text_len;               // number of queued bytes
+    SemaphoreHandle_t lock;        // protects the queue and columns
+    aespl_gfx_anim_t anim;         // animation scrolling the ticker
+    aespl_gfx_ticker_cb_t cb;      // frame callback
+    void *cb_args;                 // frame callback arguments
+} aespl_gfx_ticker_t;
+
+/**
+ * @brief Initializes a ticker.
+ *
+ * @param ticker     Ticker.
+ * @param width      Width of the ticker's buffer, usually the display's one.
+ * @param c_mode     Color mode of the ticker's buffer.
+ * @param font       Font, its characters must be up to 32 pixels wide.
+ * @param color      Text color.
+ * @param space      Space between characters.
+ * @param text_size  Maximum number of bytes of text waiting to be shown.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_ticker_init(aespl_gfx_ticker_t *ticker,
+                                      uint16_t width, aespl_gfx_c_mode_t c_mode,
+                                      const aespl_gfx_font_t *font,
+                                      uint32_t color, uint8_t space,
+                                      size_t text_size);
+
+/**
+ * @brief Frees resources of a ticker.
+ *
+ * A running ticker must be stopped before.
+ *
+ * @param ticker  Ticker.
+ */
+void aespl_gfx_ticker_deinit(aespl_gfx_ticker_t *ticker);
+
+/**
+ * @brief Appends text to a ticker.
+ *
+ * May be called from any task, including while the ticker is running.
+ *
+ * @param ticker  Ticker.
+ * @param str     Text, UTF-8 for a sparse font.
+ *
+ * @return Result of the operation, `AESPL_GFX_NO_MEM` if the text does not
+ *         fit into the queue.
+ */
+aespl_gfx_err_t aespl_gfx_ticker_append(aespl_gfx_ticker_t *ticker,
+                                        const char *str);
+
+/**
+ * @brief Scrolls a ticker by one column.
+ *
+ * Blank columns are appended when there is no text to show.
+ *
+ * @param ticker  Ticker.
+ */
+void aespl_gfx_ticker_step(aespl_gfx_ticker_t *ticker);
+
+/**
+ * @brief Checks whether a ticker has shown all of its text.
+ *
+ * The last characters may still be visible in the ticker's buffer.
+ *
+ * @param ticker  Ticker.
+ *
+ * @return Whether the ticker has nothing more to show.
+ */
+bool aespl_gfx_ticker_is_empty(aespl_gfx_ticker_t *ticker);
+
+/**
+ * @brief Starts scrolling a ticker by an animation.
+ *
+ * @param ticker   Ticker.
+ * @param fps      Columns per second.
+ * @param cb       Callback to show the ticker's buffer.
+ * @param cb_args  Callback arguments.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_ticker_start(aespl_gfx_ticker_t *ticker, uint8_t fps,
+                                       aespl_gfx_ticker_cb_t cb, void *cb_args);
+
+/**
+ * @brief Stops scrolling a ticker.
+ *
+ * Waits for the current frame to finish, unless called from the ticker's
+ * callback.
+ *
+ * @param ticker  Ticker.
+ */
+void aespl_gfx_ticker_stop(aespl_gfx_ticker_t *ticker);
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @brief     AESPL graphics, rotation and mirroring
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * MONO buffers are transformed by blocks of 8x8 pixels using bit matrix
+ * transposition and bit reversal, other color modes pixel by pixel.
+ */
+
+#ifndef _AESPL_GFX_TRANSFORM_H_
+#define _AESPL_GFX_TRANSFORM_H_
+
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_buffer.h"
+
+/**
+ * Clockwise rotations.
+ */
+typedef enum {
+    AESPL_GFX_ROTATE_0,
+    AESPL_GFX_ROTATE_90,
+    AESPL_GFX_ROTATE_180,
+    AESPL_GFX_ROTATE_270,
+} aespl_gfx_rotation_t;
+
+/**
+ * @brief Rotates a tile of 8x8 MONO pixels.
+ *
+ * @param tile  Rows of the tile, the leftmost pixel in the most significant
+ *              bit.
+ * @param rot   Rotation.
+ */
+void aespl_gfx_rotate_tile(uint8_t tile[8], aespl_gfx_rotation_t rot);
+
+/**
+ * @brief Mirrors a buffer horizontally in place.
+ *
+ * @param buf  A buffer.
+ */
+void aespl_gfx_flip_h(aespl_gfx_buf_t *buf);
+
+/**
+ * @brief Mirrors a buffer vertically in place.
+ *
+ * @param buf  A buffer.
+ */
+void aespl_gfx_flip_v(aespl_gfx_buf_t *buf);
+
+/**
+ * @brief Transposes a buffer, so that rows become columns.
+ *
+ * Buffers must have the same color mode, target's width must equal source's
+ * height and vice versa. Square buffers may be transposed in place.
+ *
+ * @param dst  Target buffer.
+ * @param src  Source buffer.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_transpose(aespl_gfx_buf_t *dst,
+                                    const aespl_gfx_buf_t *src);
+
+/**
+ * @brief Rotates a buffer.
+ *
+ * Buffers must have the same color mode and fit each other after rotation.
+ * Rotation by 180 degrees may be done in place, as well as any rotation of a
+ * square buffer.
+ *
+ * @param dst  Target buffer.
+ * @param src  Source buffer.
+ * @param rot  Rotation.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_rotate(aespl_gfx_buf_t *dst,
+                                 const aespl_gfx_buf_t *src,
+                                 aespl_gfx_rotation_t rot);
+
+/**
+ * @brief Rotates each 8x8 tile of a MONO buffer in place.
+ *
+ * Useful for chains of LED matrix modules mounted rotated.
+ *
+ * @param buf  A buffer, dimensions must be multiples of 8.
+ * @param rot  Rotation.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_rotate_tiles(aespl_gfx_buf_t *buf,
+                                       aespl_gfx_rotation_t rot);
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * @brief     AESPL graphics, tweening and timelines
+ * @author    Alexander Shepetko <a@shepetko.com>
+ * @copyright MIT License
+ *
+ * A track changes a property through keyframes using Q16.16 fixed point
+ * arithmetic and easing functions from lookup tables, so no FPU is needed.
+ * A timeline plays tracks in sequences and in parallel; only tracks which
+ * are active at a given time are evaluated.
+ */
+
+#ifndef _AESPL_GFX_TWEEN_H_
+#define _AESPL_GFX_TWEEN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aespl/gfx.h"
+#include "aespl/gfx_animation.h"
+
+/**
+ * Q16.16 fixed point number.
+ */
+typedef int32_t aespl_gfx_fixed_t;
+
+#define AESPL_GFX_FIXED_ONE (1 << 16)
+#define AESPL_GFX_FIXED(n) ((aespl_gfx_fixed_t)((n)*AESPL_GFX_FIXED_ONE))
+#define AESPL_GFX_FIXED_INT(f) ((int32_t)(f) >> 16)
+
+/**
+ * Easing functions.
+ */
+typedef enum {
+    AESPL_GFX_EASE_LINEAR,
+    AESPL_GFX_EASE_IN_QUAD,
+    AESPL_GFX_EASE_OUT_QUAD,
+    AESPL_GFX_EASE_IN_OUT_QUAD,
+    AESPL_GFX_EASE_IN_CUBIC,
+    AESPL_GFX_EASE_OUT_CUBIC,
+    AESPL_GFX_EASE_IN_OUT_CUBIC,
+    AESPL_GFX_EASE_OUT_BOUNCE,
+    AESPL_GFX_EASE_OUT_ELASTIC,
+} aespl_gfx_ease_t;
+
+/**
+ * Types of tracks' values.
+ */
+typedef enum {
+    AESPL_GFX_TRACK_FIXED,  // aespl_gfx_fixed_t, e.g. intensity
+    AESPL_GFX_TRACK_POINT,  // aespl_gfx_point_t, e.g. position
+    AESPL_GFX_TRACK_COLOR,  // ARGB888 color, channels change separately
+} aespl_gfx_track_type_t;
+
+/**
+ * Keyframe.
+ */
+typedef struct {
+    uint32_t time_ms;       // time relative to the start of the track
+    aespl_gfx_ease_t ease;  // easing of the way to this keyframe
+    union {
+        aespl_gfx_fixed_t fixed;
+        aespl_gfx_point_t point;
+        uint32_t color;
+    } value;
+} aespl_gfx_keyframe_t;
+
+/**
+ * Track.
+ */
+typedef struct aespl_gfx_track {
+    aespl_gfx_track_type_t type;          // type of the value
+    const aespl_gfx_keyframe_t *keys;     // keyframes ordered by time
+    uint8_t n_keys;                       // number of keyframes
+    void *target;                         // where to store the value
+    uint32_t start_ms;                    // start time on the timeline
+    uint8_t key_n;                        // keyframe the track heads to
+    struct aespl_gfx_track *next;         // next track by start time
+    struct aespl_gfx_track *next_active;  // next active track
+} aespl_gfx_track_t;
+
+/**
+ * Frame callback of a playing timeline, called after tracks are evaluated.
+ */
+typedef void (*aespl_gfx_timeline_cb_t)(void *args, uint32_t time_ms);
+
+/**
+ * Timeline.
+ */
+typedef struct {
+    aespl_gfx_track_t *tracks;   // tracks ordered by start time
+    aespl_gfx_track_t *pending;  // first track not started yet
+    aespl_gfx_track_t *active;   // started tracks not finished yet
+    uint32_t group_ms;           // start time of the last appended track
+    uint32_t duration_ms;        // end time of the last track
+    uint32_t time_ms;            // time of the last evaluation
+    bool loop;                   // whether playing restarts at the end
+    uint8_t fps;                 // frames per second of playing
+    aespl_gfx_timeline_cb_t cb;  // frame callback
+    void *cb_args;               // frame callback arguments
+} aespl_gfx_timeline_t;
+
+/**
+ * @brief Applies an easing function.
+ *
+ * @param ease  Easing function.
+ * @param t     Progress from 0 to `AESPL_GFX_FIXED_ONE`.
+ *
+ * @return Eased progress, may go beyond the range for elastic easing.
+ */
+aespl_gfx_fixed_t aespl_gfx_ease(aespl_gfx_ease_t ease, aespl_gfx_fixed_t t);
+
+/**
+ * @brief Initializes a track.
+ *
+ * @param track   Track.
+ * @param type    Type of the value.
+ * @param keys    Keyframes ordered by time, at least one.
+ * @param n_keys  Number of keyframes.
+ * @param target  Variable of the type to store the value to.
+ *
+ * @return Result of the operation.
+ */
+aespl_gfx_err_t aespl_gfx_track_init(aespl_gfx_track_t *track,
+                                     aespl_gfx_track_type_t type,
+                                     const aespl_gfx_keyframe_t *keys,
+                                     uint8_t n_keys, void *target);
+
+/**
+ * @brief Stores a track's value at a time.
+ *
+ * @param track    Track.
+ * @param time_ms  Time relative to the start of the track.
+ */
+void aespl_gfx_track_eval(aespl_gfx_track_t *track, uint32_t time_ms);
+
+/**
+ * @brief Initializes an empty timeline.
+ *
+ * @param tl  Timeline.
+ */
+void aespl_gfx_timeline_init(aespl_gfx_timeline_t *tl);
+
+/**
+ * @brief Adds a track starting at a given time.
+ *
+ * @param tl        Timeline.
+ * @param track     Track, must not belong to another timeline.
+ * @param start_ms  Start time on the timeline.
+ */
+void aespl_gfx_timeline_add(aespl_gfx_timeline_t *tl, aespl_gfx_track_t *track,
+                            uint32_t start_ms);
+
+/**
+ * @brief Adds a track starting after all the tracks added before.
+ *
+ * @param tl     Timeline.
+ * @param track  Track.
+ */
+void aespl_gfx_timeline_append(aespl_gfx_timeline_t *tl,
+                               aespl_gfx_track_t *track);
+
+/**
+ * @brief Adds a track starting with the last appended one.
+ *
+ * @param tl     Timeline.
+ * @param track  Track.
+ */
+void aespl_gfx_timeline_join(aespl_gfx_timeline_t *tl,
+                             aespl_gfx_track_t *track);
+
+/**
+ * @brief Stores values of the tracks which are active at a time.
+ *
+ * Time must not go backwards, except to restart the timeline. Tracks which
+ * end by the time get their final values.
+ *
+ * @param tl       Timeline.
+ * @param time_ms  Time.
+ *
+ * @return Whether any track is not finished yet.
+ */
+bool aespl_gfx_timeline_eval(aespl_gfx_timeline_t *tl, uint32_t time_ms);
+
+/**
+ * @brief Plays a timeline by an animation.
+ *
+ * @param tl       Timeline.
+ * @param fps      Frames per second.
+ * @param loop     Whether to restart at the end.
+ * @param cb       Frame callback.
+ * @param cb_args  Frame callback arguments.
+ *
+ * @return Animation handle or `AESPL_GFX_ANIM_NONE` in case of error.
+ */
+aespl_gfx_anim_t aespl_gfx_timeline_play(aespl_gfx_timeline_t *tl, uint8_t fps,
+                                         bool loop, aespl_gfx_timeline_cb_t cb,
+                                         void *cb_args);
+
+#endif
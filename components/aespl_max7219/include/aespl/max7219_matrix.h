@@ -10,6 +10,7 @@
 
 #include "aespl/gfx.h"
 #include "aespl/gfx_buffer.h"
+#include "aespl/gfx_transform.h"
 #include "aespl/max7219.h"
 #include "driver/gpio.h"
 
@@ -21,6 +22,7 @@ typedef struct {
     uint8_t disp_x;                         // number of display by X axis
     uint8_t disp_y;                         // number of display by Y axis
     uint8_t disp_reverse;                   // output displays in reverse order
+    aespl_gfx_rotation_t rotation;          // rotation of each display
 } aespl_max7219_matrix_config_t;
 
 /**
@@ -36,15 +38,39 @@ esp_err_t aespl_max7219_matrix_init(aespl_max7219_matrix_config_t *cfg,
                                     uint8_t disp_x, uint8_t disp_y,
                                     uint8_t disp_reverse);
 
+/**
+ * @brief Set rotation of displays
+ *
+ * Use it when display modules are mounted rotated, each 8x8 part of the
+ * buffer is rotated before being sent.
+ *
+ * @param cfg      Matrix configuration
+ * @param rotation Clockwise rotation
+ */
+void aespl_max7219_matrix_set_rotation(aespl_max7219_matrix_config_t *cfg,
+                                       aespl_gfx_rotation_t rotation);
+
 /**
  * @brief Draw a graphics buffer
  *
  * - buf->width must equal 8*cfg->displays_x
  * - buf->height must equal 8*cfg->displays_y
+ * - cfg must describe from 1 to 255 displays
+ *
+ * If the buffer tracks changes, only changed rows are sent and the buffer is
+ * marked as clean afterwards.
  *
  * @param cfg Configuration
  */
 esp_err_t aespl_max7219_matrix_draw(const aespl_max7219_matrix_config_t *cfg,
                                     aespl_gfx_buf_t *buf);
 
+/**
+ * @brief Draw a graphics buffer, usable as a swap chain's flush callback
+ *
+ * @param cfg Configuration, `const aespl_max7219_matrix_config_t *`
+ * @param buf Buffer
+ */
+void aespl_max7219_matrix_flush(void *cfg, aespl_gfx_buf_t *buf);
+
 #endif
@@ -8,6 +8,7 @@
 #include "aespl/max7219_matrix.h"
 
 #include "aespl/gfx_buffer.h"
+#include "aespl/gfx_transform.h"
 #include "aespl/max7219.h"
 #include "aespl/util.h"
 #include "esp_err.h"
@@ -21,36 +22,95 @@ esp_err_t aespl_max7219_matrix_init(aespl_max7219_matrix_config_t *cfg,
     cfg->disp_x = disp_x;
     cfg->disp_y = disp_y;
     cfg->disp_reverse = disp_reverse;
+    cfg->rotation = AESPL_GFX_ROTATE_0;
 
     return ESP_OK;
 }
 
+void aespl_max7219_matrix_set_rotation(aespl_max7219_matrix_config_t *cfg,
+                                       aespl_gfx_rotation_t rotation) {
+    cfg->rotation = rotation;
+}
+
+// Checks whether a digit row has changed on any display
+static bool is_row_dirty(const aespl_max7219_matrix_config_t *cfg,
+                         const aespl_gfx_buf_t *buf,
+                         const aespl_gfx_view_t *views, uint8_t n_disp,
+                         uint8_t row) {
+    uint8_t first = row, last = row;
+
+    switch (cfg->rotation) {
+        case AESPL_GFX_ROTATE_180:
+            first = last = 7 - row;
+            break;
+
+        case AESPL_GFX_ROTATE_90:
+        case AESPL_GFX_ROTATE_270:
+            // Rows are made of columns
+            first = 0;
+            last = 7;
+            break;
+
+        default:
+            break;
+    }
+
+    for (uint8_t dsp_n = 0; dsp_n < n_disp; dsp_n += cfg->disp_x) {
+        for (uint8_t r = first; r <= last; r++) {
+            if (aespl_gfx_is_row_dirty(buf, views[dsp_n].pos.y + r)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 esp_err_t aespl_max7219_matrix_draw(const aespl_max7219_matrix_config_t *cfg, aespl_gfx_buf_t *buf) {
     esp_err_t err;
-    aespl_gfx_buf_array_t *b_arr;
+    uint16_t n_disp = cfg->disp_x * cfg->disp_y;
+
+    // Arrays below must not be empty, display numbers must fit 8 bits
+    if (!n_disp || n_disp > UINT8_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    aespl_gfx_view_t views[n_disp];
+
+    uint8_t tiles[n_disp][8];
 
     // Split buffer into chunks
-    b_arr = aespl_gfx_split(buf, cfg->disp_x, cfg->disp_y);
-    if (b_arr == NULL) {
+    if (aespl_gfx_split_view(buf, cfg->disp_x, cfg->disp_y, views) != AESPL_GFX_OK) {
         return ESP_FAIL;
     }
 
+    // Rows of each display, turned the way the display is mounted
+    for (uint8_t dsp_n = 0; dsp_n < n_disp; dsp_n++) {
+        for (uint8_t r = 0; r < 8; r++) {
+            tiles[dsp_n][r] = aespl_gfx_view_get_word(&views[dsp_n], 0, r) >> 24;
+        }
+        aespl_gfx_rotate_tile(tiles[dsp_n], cfg->rotation);
+    }
+
     for (uint8_t row_n = 1; row_n <= 8; row_n++) {
-        int dsp_start = b_arr->length - 1;
+        // Skip the row if it has not changed on any display
+        if (!is_row_dirty(cfg, buf, views, n_disp, row_n - 1)) {
+            continue;
+        }
+
+        int dsp_start = n_disp - 1;
         int dsp_stop = -1;
         int dsp_step = -1;
 
         if (cfg->disp_reverse) {
             dsp_start = 0;
-            dsp_stop = b_arr->length;
+            dsp_stop = n_disp;
             dsp_step = 1;
         }
 
         for (int dsp_n = dsp_start; dsp_n != dsp_stop;
              dsp_n = dsp_n + dsp_step) {
-            uint8_t row_data =
-                *(b_arr->buffers[dsp_n]->content[row_n - 1]) >> 24;
-            err = aespl_max7219_send(cfg->max7219, row_n, row_data, false);
+            err = aespl_max7219_send(cfg->max7219, row_n, tiles[dsp_n][row_n - 1], false);
             if (err) {
                 return err;
             }
@@ -62,7 +122,11 @@ esp_err_t aespl_max7219_matrix_draw(const aespl_max7219_matrix_config_t *cfg, ae
         }
     }
 
-    aespl_gfx_free_buf_array(b_arr);
+    aespl_gfx_reset_dirty(buf);
 
     return ESP_OK;
 }
+
+void aespl_max7219_matrix_flush(void *cfg, aespl_gfx_buf_t *buf) {
+    aespl_max7219_matrix_draw((const aespl_max7219_matrix_config_t *)cfg, buf);
+}
@@ -0,0 +1,319 @@
+#!/usr/bin/env python3
+"""Converts a BDF font into an AESPL graphics sparse font header.
+
+Glyphs are cropped to their inked rows within the line and stored either as
+raw rows or as RLE nibbles, see `aespl_gfx_font_enc_t` in `aespl/gfx_text.h`.
+PCF fonts may be converted to BDF by `pcf2bdf` first.
+
+Usage:
+    bdf2font.py font.bdf name [-o font.h] [-r 32-126,0x400-0x44f] [--raw]
+    bdf2font.py font.bdf name --verify
+
+With `--verify` glyphs are encoded, decoded back and compared with the BDF
+bitmaps, nothing is written.
+
+`test/font_test.sh` checks converted glyphs against the decoders of
+`gfx_text.c` on the host.
+"""
+
+import argparse
+import sys
+
+
+class Glyph:
+    def __init__(self, code, width, top, rows):
+        self.code = code
+        self.width = width  # number of columns, also the advance
+        self.top = top      # number of empty rows above the glyph
+        self.rows = rows    # lists of pixels, True for set ones
+
+
+def parse_ranges(spec):
+    codes = set()
+    for part in spec.split(','):
+        lo, _, hi = part.partition('-')
+        lo = int(lo, 0)
+        codes.update(range(lo, int(hi, 0) + 1 if hi else lo + 1))
+    return codes
+
+
+def read_bdf(path):
+    """Returns line height and glyphs sorted by code point."""
+    ascent = descent = None
+    bbox = None
+    glyphs = []
+
+    with open(path, encoding='latin-1') as f:
+        lines = iter(f.read().splitlines())
+
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+
+        if words[0] == 'FONTBOUNDINGBOX':
+            bbox = [int(v) for v in words[1:5]]
+        elif words[0] == 'FONT_ASCENT':
+            ascent = int(words[1])
+        elif words[0] == 'FONT_DESCENT':
+            descent = int(words[1])
+        elif words[0] == 'STARTCHAR':
+            glyph = read_char(lines, ascent if ascent is not None
+                              else bbox[1] + bbox[3])
+            if glyph:
+                glyphs.append(glyph)
+
+    if ascent is None or descent is None:
+        ascent, descent = bbox[1] + bbox[3], -bbox[3]
+
+    height = ascent + descent
+    for g in glyphs:
+        crop_rows(g, height)
+
+    glyphs.sort(key=lambda g: g.code)
+
+    return height, glyphs
+
+
+def read_char(lines, ascent):
+    code = dwidth = bbx = None
+    bitmap = []
+
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+
+        if words[0] == 'ENCODING':
+            code = int(words[-1])
+        elif words[0] == 'DWIDTH':
+            dwidth = int(words[1])
+        elif words[0] == 'BBX':
+            bbx = [int(v) for v in words[1:5]]
+        elif words[0] == 'BITMAP':
+            for row in lines:
+                if row.strip() == 'ENDCHAR':
+                    break
+                row = row.strip()
+                bitmap.append((int(row, 16) if row else 0, len(row) * 4))
+            break
+
+    if code is None or code < 0:
+        return None
+
+    w, h, x_off, y_off = bbx
+    width = dwidth if dwidth is not None else w + x_off
+    top = ascent - (y_off + h)
+
+    # Pixels are placed at their horizontal offset, those beyond the advance
+    # are dropped
+    rows = []
+    for value, row_bits in bitmap[:h]:
+        px = [False] * width
+        for col in range(w):
+            x = x_off + col
+            if 0 <= x < width and value >> (row_bits - 1 - col) & 1:
+                px[x] = True
+        rows.append(px)
+
+    return Glyph(code, width, top, rows)
+
+
+def crop_rows(glyph, height):
+    """Crops rows outside of the line and empty rows of a glyph."""
+    rows, top = glyph.rows, glyph.top
+
+    # Parts of glyphs which rise above the ascent, e.g. accents of capitals,
+    # or go below the descent can't be drawn
+    inked = [i for i, px in enumerate(rows) if any(px)]
+    if inked and (top + inked[0] < 0 or top + inked[-1] >= height):
+        print('warning: glyph %s is cropped to the line' %
+              char_comment(glyph.code), file=sys.stderr)
+    if top < 0:
+        rows = rows[-top:]
+        top = 0
+    rows = rows[:max(height - top, 0)]
+
+    while rows and not any(rows[0]):
+        rows.pop(0)
+        top += 1
+    while rows and not any(rows[-1]):
+        rows.pop()
+    if not rows:
+        top = 0
+
+    glyph.rows, glyph.top = rows, top
+
+
+def encode_raw(glyph):
+    data = bytearray()
+    for px in glyph.rows:
+        for i in range(0, glyph.width, 8):
+            byte = 0
+            for bit, on in enumerate(px[i:i + 8]):
+                byte |= on << (7 - bit)
+            data.append(byte)
+    return bytes(data)
+
+
+def decode_raw(data, width, height):
+    bpr = (width + 7) // 8
+    return [[bool(data[y * bpr + x // 8] & (0x80 >> x % 8))
+             for x in range(width)] for y in range(height)]
+
+
+def encode_rle(glyph):
+    pixels = [on for px in glyph.rows for on in px]
+    runs = []
+    on, n = False, 0
+    for p in pixels:
+        if p != on:
+            runs.append(n)
+            on, n = p, 0
+        n += 1
+    if pixels:
+        runs.append(n)
+
+    nibbles = []
+    for n in runs:
+        while n >= 15:
+            nibbles.append(15)
+            n -= 15
+        nibbles.append(n)
+    if len(nibbles) % 2:
+        nibbles.append(0)
+
+    return bytes(hi << 4 | lo for hi, lo in zip(nibbles[::2], nibbles[1::2]))
+
+
+def decode_rle(data, width, height):
+    """Mirrors the decoder of `gfx_text.c`."""
+    nibble = 0
+    run, on = 0, True
+
+    def read_run():
+        nonlocal nibble
+        n, total = 15, 0
+        while n == 15:
+            byte = data[nibble // 2]
+            n = byte & 0xf if nibble % 2 else byte >> 4
+            nibble += 1
+            total += n
+        return total
+
+    rows = []
+    for _ in range(height):
+        px = []
+        while len(px) < width:
+            while not run:
+                on = not on
+                run = read_run()
+            n = min(run, width - len(px))
+            px += [on] * n
+            run -= n
+        rows.append(px)
+
+    return rows
+
+
+ENCODERS = {
+    'AESPL_GFX_FONT_ENC_RAW': (encode_raw, decode_raw),
+    'AESPL_GFX_FONT_ENC_RLE': (encode_rle, decode_rle),
+}
+
+
+def char_comment(code):
+    if 32 < code < 0x7f or code > 0xa0:
+        return '%s - U+%04X' % (chr(code), code)
+    return 'U+%04X' % code
+
+
+def write_header(out, name, height, glyphs, enc, data):
+    guard = '_AESPL_GFX_FONT_%s_H_' % name.upper()
+
+    out.write('/**\n')
+    out.write(' * @brief     AESPL graphics, font %s\n' % name)
+    out.write(' * @copyright MIT License\n')
+    out.write(' *\n')
+    out.write(' * Generated by tools/bdf2font.py.\n')
+    out.write(' */\n\n')
+    out.write('#ifndef %s\n#define %s\n\n' % (guard, guard))
+    out.write('#include "aespl/gfx_text.h"\n\n')
+
+    out.write('static const uint8_t _font_%s_bitmap[] = {\n' % name)
+    for glyph, chunk in data:
+        for i in range(0, len(chunk), 8):
+            out.write('        %s' % ' '.join(
+                '0x%02x,' % b for b in chunk[i:i + 8]))
+            out.write('  // %s\n' % char_comment(glyph.code) if not i else '\n')
+    out.write('};\n\n')
+
+    out.write('static const aespl_gfx_glyph_t _font_%s_glyphs[] = {\n' % name)
+    offset = 0
+    for glyph, chunk in data:
+        out.write('        {0x%04x, %d, %d, %d, %d},  // %s\n' % (
+            glyph.code, offset, glyph.width, len(glyph.rows), glyph.top,
+            char_comment(glyph.code)))
+        offset += len(chunk)
+    out.write('};\n\n')
+
+    out.write('aespl_gfx_font_t font_%s = {\n' % name)
+    out.write('        .height = %d,\n' % height)
+    out.write('        .n_glyphs = %d,\n' % len(glyphs))
+    out.write('        .glyphs = _font_%s_glyphs,\n' % name)
+    out.write('        .bitmap = _font_%s_bitmap,\n' % name)
+    out.write('        .enc = %s,\n' % enc)
+    out.write('};\n\n')
+    out.write('#endif\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Converts a BDF font into an AESPL graphics sparse font.')
+    parser.add_argument('bdf', help='BDF font')
+    parser.add_argument('name', help='name of the font variable suffix')
+    parser.add_argument('-o', '--output', help='header, stdout by default')
+    parser.add_argument('-r', '--ranges',
+                        help='code points to keep, e.g. 32-126,0x400-0x44f')
+    parser.add_argument('--raw', action='store_true',
+                        help='store raw rows instead of RLE')
+    parser.add_argument('--verify', action='store_true',
+                        help='check that glyphs decode back unchanged')
+    args = parser.parse_args()
+
+    height, glyphs = read_bdf(args.bdf)
+    if args.ranges:
+        keep = parse_ranges(args.ranges)
+        glyphs = [g for g in glyphs if g.code in keep]
+
+    for g in glyphs:
+        if g.width > 32 or len(g.rows) + g.top > 255:
+            sys.exit('glyph %s is too large' % char_comment(g.code))
+    if len(glyphs) > 0xffff:
+        sys.exit('too many glyphs')
+
+    enc = 'AESPL_GFX_FONT_ENC_RAW' if args.raw else 'AESPL_GFX_FONT_ENC_RLE'
+    encode, decode = ENCODERS[enc]
+    data = [(g, encode(g)) for g in glyphs]
+
+    if args.verify:
+        failed = 0
+        for g, chunk in data:
+            if decode(chunk, g.width, len(g.rows)) != g.rows:
+                print('mismatch: %s' % char_comment(g.code), file=sys.stderr)
+                failed += 1
+        size = sum(len(chunk) for _, chunk in data)
+        raw = sum(len(encode_raw(g)) for g in glyphs)
+        print('%d glyphs, %d bytes of bitmap (%d raw), %d mismatches' % (
+            len(glyphs), size, raw, failed))
+        sys.exit(1 if failed else 0)
+
+    if args.output:
+        with open(args.output, 'w') as out:
+            write_header(out, args.name, height, glyphs, enc, data)
+    else:
+        write_header(sys.stdout, args.name, height, glyphs, enc, data)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,179 @@
+/**
+ * Round-trip test of tools/bdf2font.py and the glyph decoders of gfx_text.c.
+ *
+ * Every glyph of a BDF font is drawn by `aespl_gfx_putc()` from the RAW and
+ * the RLE headers generated by the converter and compared with the BDF
+ * bitmap, pixels outside of the line are expected to be cropped. Built and
+ * run on the host by font_test.sh.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aespl/gfx_buffer.h"
+#include "aespl/gfx_text.h"
+#include "font_test_raw.h"
+#include "font_test_rle.h"
+
+#define BUF_WIDTH 64
+
+typedef struct {
+    uint32_t code;
+    int width;
+    int w, h, x_off, y_off;
+    uint64_t rows[256];
+    int row_bits[256];
+} bdf_glyph_t;
+
+// Reads the next glyph of a BDF font, returns false at the end
+static bool bdf_next(FILE *f, bdf_glyph_t *g, int *ascent, int *descent) {
+    char line[256];
+    bool have_dwidth = false;
+
+    memset(g, 0, sizeof(*g));
+    g->code = UINT32_MAX;
+
+    while (fgets(line, sizeof(line), f)) {
+        int a, b, c, d;
+
+        if (sscanf(line, "FONT_ASCENT %d", &a) == 1) {
+            *ascent = a;
+        } else if (sscanf(line, "FONT_DESCENT %d", &a) == 1) {
+            *descent = a;
+        } else if (sscanf(line, "ENCODING %d", &a) == 1) {
+            g->code = a;
+        } else if (sscanf(line, "DWIDTH %d", &a) == 1) {
+            g->width = a;
+            have_dwidth = true;
+        } else if (sscanf(line, "BBX %d %d %d %d", &a, &b, &c, &d) == 4) {
+            g->w = a;
+            g->h = b;
+            g->x_off = c;
+            g->y_off = d;
+        } else if (!strncmp(line, "BITMAP", 6)) {
+            for (int r = 0; fgets(line, sizeof(line), f); r++) {
+                if (!strncmp(line, "ENDCHAR", 7)) {
+                    break;
+                }
+                line[strcspn(line, "\r\n")] = 0;
+                g->rows[r] = strtoull(line, NULL, 16);
+                g->row_bits[r] = strlen(line) * 4;
+            }
+            if (!have_dwidth) {
+                g->width = g->w + g->x_off;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Whether a pixel of a glyph's line is set according to the BDF bitmap
+static bool bdf_px(const bdf_glyph_t *g, int ascent, int height, int x,
+                   int y) {
+    if (x < 0 || x >= g->width || x >= 32 || y < 0 || y >= height) {
+        return false;
+    }
+
+    int r = y - (ascent - (g->y_off + g->h));
+    int c = x - g->x_off;
+    if (r < 0 || r >= g->h || c < 0 || c >= g->w) {
+        return false;
+    }
+
+    return g->rows[r] >> (g->row_bits[r] - 1 - c) & 1;
+}
+
+// Draws a glyph in a given color mode and compares it with the BDF bitmap
+static int check_glyph(const aespl_gfx_font_t *font, const char *name,
+                       aespl_gfx_c_mode_t c_mode, const bdf_glyph_t *g,
+                       int ascent, int16_t x) {
+    aespl_gfx_buf_t *buf = aespl_gfx_make_buf(BUF_WIDTH, font->height, c_mode);
+    if (!buf) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    int failed = 0;
+    int8_t w = aespl_gfx_putc(buf, font, (aespl_gfx_point_t){x, 0}, g->code,
+                              0xffffffff);
+    if (w != g->width) {
+        fprintf(stderr, "%s U+%04X: width %d, expected %d\n", name, g->code,
+                w, g->width);
+        failed = 1;
+    }
+
+    for (int16_t py = 0; py < font->height && !failed; py++) {
+        for (int16_t px = 0; px < BUF_WIDTH; px++) {
+            bool got = aespl_gfx_get_px(buf, px, py) != 0;
+            if (got != bdf_px(g, ascent, font->height, px - x, py)) {
+                fprintf(stderr, "%s U+%04X: pixel %d,%d mode %d x %d\n", name,
+                        g->code, px - x, py, c_mode, x);
+                failed = 1;
+                break;
+            }
+        }
+    }
+
+    aespl_gfx_free_buf(buf);
+
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    const struct {
+        const aespl_gfx_font_t *font;
+        const char *name;
+    } fonts[] = {{&font_test_raw, "raw"}, {&font_test_rle, "rle"}};
+    const aespl_gfx_c_mode_t c_modes[] = {AESPL_GFX_C_MODE_MONO,
+                                          AESPL_GFX_C_MODE_ARGB888};
+    const int16_t xs[] = {0, 13, -3};
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s font.bdf\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    int ascent = 0, descent = 0, n_glyphs = 0, failed = 0;
+    static bdf_glyph_t g;
+    while (bdf_next(f, &g, &ascent, &descent)) {
+        if (g.code == UINT32_MAX) {
+            continue;
+        }
+        n_glyphs++;
+
+        for (size_t i = 0; i < sizeof(fonts) / sizeof(fonts[0]); i++) {
+            for (size_t m = 0; m < sizeof(c_modes) / sizeof(c_modes[0]); m++) {
+                for (size_t k = 0; k < sizeof(xs) / sizeof(xs[0]); k++) {
+                    failed += check_glyph(fonts[i].font, fonts[i].name,
+                                          c_modes[m], &g, ascent, xs[k]);
+                }
+            }
+        }
+    }
+    fclose(f);
+
+    for (size_t i = 0; i < sizeof(fonts) / sizeof(fonts[0]); i++) {
+        if (fonts[i].font->n_glyphs != n_glyphs ||
+            fonts[i].font->height != ascent + descent) {
+            fprintf(stderr, "%s: %d glyphs, %d rows, expected %d and %d\n",
+                    fonts[i].name, fonts[i].font->n_glyphs,
+                    fonts[i].font->height, n_glyphs, ascent + descent);
+            failed++;
+        }
+    }
+
+    printf("%d glyphs, %d failures\n", n_glyphs, failed);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Round-trip test of tools/bdf2font.py and the glyph decoders of gfx_text.c,
+# built and run on the host.
+#
+# Usage: font_test.sh [font.bdf]
+
+set -e
+
+TEST_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT=$TEST_DIR/../..
+GFX=$ROOT/components/aespl_gfx
+BDF=${1:-$TEST_DIR/font_test.bdf}
+
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+python3 "$ROOT/tools/bdf2font.py" "$BDF" test_raw --raw \
+    -o "$OUT/font_test_raw.h"
+python3 "$ROOT/tools/bdf2font.py" "$BDF" test_rle -o "$OUT/font_test_rle.h"
+
+${CC:-cc} -std=gnu11 -Wall -Wextra -g ${CFLAGS} \
+    -I"$OUT" -I"$ROOT" -I"$GFX/include" -I"$ROOT/components/aespl_util/include" \
+    "$TEST_DIR/font_test.c" "$GFX/gfx_text.c" "$GFX/gfx_buffer.c" \
+    "$GFX/gfx_color.c" "$GFX/gfx_geometry.c" "$GFX/gfx_pool.c" \
+    "$ROOT/components/aespl_util/util.c" \
+    -o "$OUT/font_test"
+
+"$OUT/font_test" "$BDF"